@@ -0,0 +1,113 @@
+#!/usr/bin/env python3
+"""
+Compare simulation benchmark results against a stored baseline
+
+Usage:
+    python bench_compare.py BASELINE CURRENT [options]
+
+Options:
+    --threshold F       Allowed relative regression per metric (default: 0.10)
+    --ignore METRICS    Comma-separated metrics to report but never fail on
+    --min-time SEC      Times below SEC in both runs are too noisy to fail
+                        on (default: 0.05)
+    --allow-missing     Do not fail when the baseline file does not exist
+    --help              Show this help message
+
+Metrics ending in '_s' are times (lower is better), metrics ending in
+'_per_s' or '_per_cycle' are rates (higher is better). Other keys such as
+the seed or raw counts are informational and are not compared.
+
+Exit status is 1 when any compared metric regresses by more than the
+threshold or when the baseline is missing (unless --allow-missing), 0
+otherwise.
+
+Examples:
+    # Check the latest run against the committed baseline
+    python bench_compare.py bench/baseline.json build/bench/bench.json
+
+    # Build time is noisy on shared machines
+    python bench_compare.py bench/baseline.json build/bench/bench.json \\
+        --threshold 0.05 --ignore build_s
+"""
+
+import argparse
+import json
+import sys
+
+
+def metric_direction(name):
+    if name.endswith('_per_s') or name.endswith('_per_cycle'):
+        return 1
+    if name.endswith('_s'):
+        return -1
+    return 0
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description='Compare simulation benchmark results',
+        formatter_class=argparse.RawDescriptionHelpFormatter,
+        epilog=__doc__
+    )
+    parser.add_argument('baseline', help='Baseline JSON file')
+    parser.add_argument('current', help='Current JSON file')
+    parser.add_argument('--threshold', type=float, default=0.10,
+                        help='Allowed relative regression (default: 0.10)')
+    parser.add_argument('--ignore', default='',
+                        help='Comma-separated metrics that never fail')
+    parser.add_argument('--min-time', type=float, default=0.05,
+                        help='Noise floor for time metrics (default: 0.05)')
+    parser.add_argument('--allow-missing', action='store_true',
+                        help='Pass when there is no baseline yet')
+
+    args = parser.parse_args()
+
+    try:
+        with open(args.current) as f:
+            current = json.load(f)
+    except FileNotFoundError:
+        print(f"Error: File '{args.current}' not found")
+        sys.exit(1)
+
+    try:
+        with open(args.baseline) as f:
+            baseline = json.load(f)
+    except FileNotFoundError:
+        print(f"{'Warning' if args.allow_missing else 'Error'}: "
+              f"No baseline at '{args.baseline}', nothing to compare")
+        print("Record one with: make bench-baseline")
+        sys.exit(0 if args.allow_missing else 1)
+
+    ignored = {m.strip() for m in args.ignore.split(',') if m.strip()}
+
+    print(f"{'Metric':<20} {'Baseline':>14} {'Current':>14} {'Change':>9}  Status")
+    print('-' * 68)
+
+    regressions = []
+    for name, cur in current.items():
+        direction = metric_direction(name)
+        if direction == 0 or name not in baseline:
+            continue
+        base = baseline[name]
+        change = (cur - base) / base if base else 0.0
+        regressed = change * direction < -args.threshold
+        if direction < 0 and max(base, cur) < args.min_time:
+            regressed = False
+        if regressed and name in ignored:
+            status = 'ignored'
+        elif regressed:
+            status = 'REGRESSION'
+            regressions.append(name)
+        else:
+            status = 'ok'
+        print(f"{name:<20} {base:>14.6g} {cur:>14.6g} {change:>+8.1%}  {status}")
+
+    if regressions:
+        print(f"\n{len(regressions)} metric(s) regressed beyond "
+              f"{args.threshold:.0%}: {', '.join(regressions)}")
+        sys.exit(1)
+    print(f"\nNo regressions beyond {args.threshold:.0%}")
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,428 @@
+#!/usr/bin/env python3
+"""
+Design-space exploration over the TANHFP32 generator parameters
+
+Usage:
+    python dse.py [options]
+
+Options:
+    --seg-bits LIST     Segment index mantissa bits to sweep (default: 2,3,4)
+    --degree LIST       Polynomial degrees to sweep (default: 1,2)
+    --engine LIST       Horner step engines: fma, muladd (default: fma,muladd)
+    --mul-trunc LIST    Product columns dropped by the multiplier (default: 0)
+    --add-width LIST    Product bits into the FMA adder, 26..48 (default: 48)
+    --fwd-width LIST    Accumulator bits forwarded between CMAs, 24..29
+                        (default: 24, rounded to FP32)
+    --fixup LIST        ULP bounds for a fix-up table, or none (default: none)
+    --pipe LIST         Pipeline presets or 9-flag strings (default: full,lean)
+    --format LIST       IN:OUT data formats, e.g. int8:int8 (default: fp32:fp32)
+    --jobs N            Points evaluated in parallel (default: CPU count)
+    --out DIR           Work and cache directory (default: build/dse)
+    --range LO:HI       Input bit patterns for the ULP sweep, HI exclusive
+                        (default: 0:0x80000000, negative inputs mirror)
+    --ref R             Accuracy reference: glibc or cr (default: glibc)
+    --force             Re-run every step instead of using cached results
+    --all               List dominated points as well as the Pareto front
+    --help              Show this help message
+
+For each point the driver fits coefficients with remez.py, elaborates the
+RTL with TANHFP32Gen, synthesizes it with yosys (generic gates: cell count,
+flip-flops and the longest combinational path in gates) and measures
+accuracy over the whole input range on the bit-accurate model
+(TANHFP32_ulpsweep). Every step is cached under --out, keyed by its inputs,
+so a changed axis only re-runs what depends on it. A --fwd-width above 24
+needs the exact fma datapath; other combinations with it are skipped. When a
+run includes width 24 as well, each wider point is also listed against its
+width-24 twin: the change in latency, cells, flip-flops, depth and max ULP is
+what the wider forwarding costs and buys.
+
+A --fixup bound adds a CAM of every input the sweep finds above that many
+ULP, holding the reference result; its accuracy is that of the model with
+the table, and points whose table exceeds the RTL limit fail. Comparing
+such points with more segment bits shows which reaches a bound cheaper. The accuracy columns are
+those of the FP32 core, which every format shares; the quantized conversions
+are checked exhaustively by make quant.
+
+The Pareto front minimizes max ULP, cells and latency. Pipeline presets
+(flags: filter, segment, lut, mul s1-s3, add s1-s2, out):
+    full    111111111   every stage registered (the committed RTL)
+    lean    001101011   filter/segment/LUT in one stage, 2-stage mul, 1-stage add
+    min     000000001   output register only
+
+Examples:
+    # Default sweep, 8 points in parallel
+    python dse.py --jobs 8
+
+    # Accuracy of cubic fits only, on a slice of the domain
+    python dse.py --degree 3 --pipe full --range 0x3c000000:0x41000000
+
+    # Truncated multipliers against the full-width datapath
+    python dse.py --engine fma --mul-trunc 0,8,16 --add-width 48,32
+
+    # Forwarding the accumulator wider than FP32 between the Horner steps
+    python dse.py --engine fma --degree 2,3 --fwd-width 24,26,29
+
+    # Fix-up tables against finer segmentation
+    python dse.py --seg-bits 4,5,6 --degree 2 --fixup none,2,4 --ref cr
+"""
+
+import argparse
+import concurrent.futures
+import csv
+import glob
+import hashlib
+import json
+import os
+import re
+import subprocess
+import sys
+
+
+PIPE_PRESETS = {
+    'full': '111111111',
+    'lean': '001101011',
+    'min':  '000000001',
+}
+
+SCALA_SRC = 'src/scala/TANHFP32.scala'
+ULPSWEEP = 'build/TANHFP32_ulpsweep'
+# Everything the Makefile compiles into ULPSWEEP
+ULPSWEEP_SRC = ['sim-verilator/TANHFP32_ulpsweep.cpp',
+                'sim-verilator/TANHFP32_ref.cpp',
+                'sim-verilator/TANHFP32_model.cpp',
+                'sim-verilator/TANHFP32_stats.cpp']
+
+YOSYS_SCRIPT = """read_verilog -sv {rtl}
+synth -flatten -top TANHFP32
+ltp -noff
+stat
+"""
+
+
+def file_hash(*paths):
+    h = hashlib.sha1()
+    for path in paths:
+        with open(path, 'rb') as f:
+            h.update(f.read())
+    return h.hexdigest()
+
+
+def generator_src():
+    """Every source the elaborated RTL depends on, fudian included"""
+    return [SCALA_SRC, 'build.sc'] + sorted(
+        glob.glob('dependencies/fudian/**/*.scala', recursive=True))
+
+
+def ulpsweep_src():
+    """Sources and binary of the accuracy sweep"""
+    return ULPSWEEP_SRC + sorted(glob.glob('sim-verilator/*.h')) + [ULPSWEEP]
+
+
+def cached(path, key, force, run):
+    """Return the JSON at path if it was produced from key, else run()"""
+    stamp = path + '.key'
+    if not force and os.path.exists(path) and os.path.exists(stamp):
+        with open(stamp) as f:
+            if f.read() == key:
+                with open(path) as f:
+                    return json.load(f)
+    result = run()
+    os.makedirs(os.path.dirname(path), exist_ok=True)
+    with open(path, 'w') as f:
+        json.dump(result, f, indent=2)
+    with open(stamp, 'w') as f:
+        f.write(key)
+    return result
+
+
+def run(cmd, log):
+    with open(log, 'w') as f:
+        proc = subprocess.run(cmd, stdout=f, stderr=subprocess.STDOUT)
+    if proc.returncode != 0:
+        raise RuntimeError(f"'{' '.join(cmd)}' failed, see {log}")
+
+
+def latency(pipe, degree):
+    """Same count as TANHFP32PipeConfig.latency"""
+    flags = [c == '1' for c in pipe]
+    return sum(flags[0:3]) + flags[8] + degree * sum(flags[3:8])
+
+
+def fit_lut(args, seg_bits, degree):
+    lut = os.path.join(args.out, 'lut', f's{seg_bits}_d{degree}.txt')
+    key = f'{seg_bits},{degree},{file_hash("remez.py")}'
+
+    def fit():
+        os.makedirs(os.path.dirname(lut), exist_ok=True)
+        run([sys.executable, 'remez.py', '--seg-bits', str(seg_bits),
+             '--degree', str(degree), '--output', lut], lut + '.log')
+        return {'lut': lut}
+
+    return cached(lut + '.json', key, args.force, fit)['lut']
+
+
+def measure_ulp(args, seg_bits, degree, engine, mul_trunc, add_width,
+                fwd_width, fixup, lut):
+    name = f's{seg_bits}_d{degree}_{engine}_t{mul_trunc}_w{add_width}'
+    if fwd_width != 24:
+        name += f'_fwd{fwd_width}'
+    if fixup is not None:
+        name += f'_fix{fixup}'
+    path = os.path.join(args.out, 'ulp', name + '.json')
+    key = ','.join([args.range, args.ref, file_hash(lut, *ulpsweep_src())])
+
+    def sweep():
+        cmd = [ULPSWEEP, '--lut', lut, '--seg-bits', str(seg_bits),
+               '--degree', str(degree), '--engine', engine,
+               '--mul-trunc', str(mul_trunc), '--add-width', str(add_width),
+               '--fwd-width', str(fwd_width), '--ref', args.ref, '--range', args.range, '--json', path + '.tmp']
+        if fixup is not None:
+            table = os.path.join(args.out, 'ulp', name + '.fixup.txt')
+            cmd += ['--fixup-bound', str(fixup), '--fixup-out', table]
+        run(cmd, path + '.log')
+        with open(path + '.tmp') as f:
+            result = json.load(f)
+        os.remove(path + '.tmp')
+        if fixup is not None:
+            result['fixup'] = table
+        return result
+
+    return cached(path, key, args.force, sweep)
+
+
+def synthesize(rtl, log):
+    script = log.replace('.log', '.ys')
+    with open(script, 'w') as f:
+        f.write(YOSYS_SCRIPT.format(rtl=rtl))
+    run(['yosys', '-q', '-l', log, '-s', script], log + '.stdout')
+
+    with open(log) as f:
+        text = f.read()
+    # Last statistics block is the flattened top; both stat output styles
+    top = text[max(text.rfind('=== TANHFP32 ==='), 0):]
+    cells = re.findall(r'Number of cells:\s+(\d+)', top) or \
+        re.findall(r'^\s+(\d+)\s+cells$', top, re.M)
+    ffs = re.findall(r'^\s+\$_\w*DFF\w*\s+(\d+)', top, re.M) or \
+        re.findall(r'^\s+(\d+)\s+\$_\w*DFF\w*', top, re.M)
+    depth = re.findall(r'Longest topological path in \S+ \(length=(\d+)\)', text)
+    if not cells or not depth:
+        raise RuntimeError(f'could not parse yosys output {log}')
+    return {'cells': int(cells[0]), 'ffs': sum(map(int, ffs)),
+            'depth': int(depth[-1])}
+
+
+def evaluate(args, jar, point, lut, ulp_sweep):
+    seg_bits, degree, engine, mul_trunc, add_width, fwd_width, fixup, pipe, fmt = point
+    in_fmt, out_fmt = fmt.split(':')
+    name = f's{seg_bits}_d{degree}_{engine}_t{mul_trunc}_w{add_width}_'
+    if fwd_width != 24:
+        name += f'fwd{fwd_width}_'
+    if fixup is not None:
+        name += f'fix{fixup}_'
+    name += f'{pipe}_{in_fmt}_{out_fmt}'
+    pdir = os.path.join(args.out, 'points', name)
+    os.makedirs(pdir, exist_ok=True)
+    # The fix-up table comes out of this point's accuracy sweep
+    table = ulp_sweep.result()['fixup'] if fixup is not None else None
+    key = ','.join([name, file_hash(lut, 'dse.py', *generator_src(),
+                                    *([table] if table else []))])
+
+    def elaborate_and_synth():
+        rtl_dir = os.path.join(pdir, 'rtl')
+        run(['java', '-cp', jar, 'TANHFP32Gen', '--seg-bits', str(seg_bits),
+             '--degree', str(degree), '--engine', engine, '--pipe', pipe,
+             '--mul-trunc', str(mul_trunc), '--add-width', str(add_width),
+             '--fwd-width', str(fwd_width), '--in-format', in_fmt, '--out-format', out_fmt, '--lut', lut,
+             '--target-dir', rtl_dir] + (['--fixup', table] if table else []),
+            os.path.join(pdir, 'elaborate.log'))
+        return synthesize(os.path.join(rtl_dir, 'TANHFP32.sv'),
+                          os.path.join(pdir, 'yosys.log'))
+
+    synth = cached(os.path.join(pdir, 'synth.json'), key, args.force,
+                   elaborate_and_synth)
+    return {
+        'point': name, 'seg_bits': seg_bits, 'degree': degree,
+        'engine': engine, 'mul_trunc': mul_trunc, 'add_width': add_width,
+        'fwd_width': fwd_width, 'fixup': fixup, 'pipe': pipe, 'format': fmt,
+        'latency': latency(pipe, degree), **synth,
+    }
+
+
+def pareto(rows, keys=('max_ulp', 'cells', 'latency')):
+    def dominates(a, b):
+        return all(a[k] <= b[k] for k in keys) and any(a[k] < b[k] for k in keys)
+    return [r for r in rows if not any(dominates(o, r) for o in rows)]
+
+
+def print_fwd_tradeoff(rows):
+    """Each --fwd-width point against the same point forwarding 24 bits"""
+    axes = ('seg_bits', 'degree', 'engine', 'mul_trunc', 'add_width',
+            'fixup', 'pipe', 'format')
+    narrow = {tuple(r[a] for a in axes): r for r in rows if r['fwd_width'] == 24}
+    pairs = [(r, narrow[tuple(r[a] for a in axes)]) for r in rows
+             if r['fwd_width'] != 24 and tuple(r[a] for a in axes) in narrow]
+    if not pairs:
+        return
+    pairs.sort(key=lambda p: (p[0]['point'], p[0]['fwd_width']))
+    print("\nForwarding width against the same point at 24 bits")
+    print(f"{'Point':<52} {'Fwd':>3} {'dLat':>5} {'dCells':>8} {'dFFs':>6} "
+          f"{'dDepth':>6} {'MaxULP':>15}")
+    print('-' * 101)
+    for r, b in pairs:
+        print(f"{r['point']:<52} {r['fwd_width']:>3} "
+              f"{r['latency'] - b['latency']:>+5} {r['cells'] - b['cells']:>+8} "
+              f"{r['ffs'] - b['ffs']:>+6} {r['depth'] - b['depth']:>+6} "
+              f"{str(b['max_ulp']) + ' -> ' + str(r['max_ulp']):>15}")
+
+
+def assembly_jar():
+    out = subprocess.run(['./mill', '--no-server', 'show', 'TANHFP32.assembly'],
+                         capture_output=True, text=True)
+    if out.returncode != 0:
+        print(out.stderr)
+        raise RuntimeError('mill assembly failed')
+    # "ref:<hash>:<path>", the path is last
+    return json.loads(out.stdout.strip().splitlines()[-1]).split(':')[-1]
+
+
+def int_list(s):
+    return [int(v) for v in s.split(',')]
+
+
+def str_list(s):
+    return [v.strip() for v in s.split(',') if v.strip()]
+
+
+def bound_list(s):
+    return [None if v == 'none' else int(v) for v in str_list(s)]
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description='TANHFP32 design-space exploration',
+        formatter_class=argparse.RawDescriptionHelpFormatter,
+        epilog=__doc__
+    )
+    parser.add_argument('--seg-bits', type=int_list, default=[2, 3, 4],
+                        help='Segment index mantissa bits (default: 2,3,4)')
+    parser.add_argument('--degree', type=int_list, default=[1, 2],
+                        help='Polynomial degrees (default: 1,2)')
+    parser.add_argument('--engine', type=str_list, default=['fma', 'muladd'],
+                        help='Horner step engines (default: fma,muladd)')
+    parser.add_argument('--mul-trunc', type=int_list, default=[0],
+                        help='Multiplier columns dropped (default: 0)')
+    parser.add_argument('--add-width', type=int_list, default=[48],
+                        help='Product bits into the FMA adder (default: 48)')
+    parser.add_argument('--fwd-width', type=int_list, default=[24],
+                        help='Accumulator bits between CMAs (default: 24)')
+    parser.add_argument('--fixup', type=bound_list, default=[None],
+                        help='Fix-up table ULP bounds or none (default: none)')
+    parser.add_argument('--pipe', type=str_list, default=['full', 'lean'],
+                        help='Pipeline presets or flag strings (default: full,lean)')
+    parser.add_argument('--format', type=str_list, default=['fp32:fp32'],
+                        help='IN:OUT data formats (default: fp32:fp32)')
+    parser.add_argument('--jobs', type=int, default=os.cpu_count(),
+                        help='Points evaluated in parallel (default: CPU count)')
+    parser.add_argument('--out', default='build/dse',
+                        help='Work and cache directory (default: build/dse)')
+    parser.add_argument('--range', default='0:0x80000000',
+                        help='ULP sweep range (default: 0:0x80000000)')
+    parser.add_argument('--ref', default='glibc', choices=['glibc', 'cr'],
+                        help='Accuracy reference (default: glibc)')
+    parser.add_argument('--force', action='store_true',
+                        help='Ignore cached results')
+    parser.add_argument('--all', action='store_true',
+                        help='List dominated points too')
+
+    args = parser.parse_args()
+
+    pipes = []
+    for p in args.pipe:
+        flags = PIPE_PRESETS.get(p, p)
+        if not re.fullmatch(r'[01]{9}', flags):
+            print(f"Error: '{p}' is neither a preset nor 9 pipe flags")
+            sys.exit(1)
+        pipes.append(flags)
+    for fmt in args.format:
+        if not re.fullmatch(r'(fp32|int8|int16):(fp32|bf16|int8|int16)', fmt):
+            print(f"Error: Unsupported format '{fmt}' (IN: fp32, int8, int16; "
+                  "OUT: fp32, bf16, int8, int16)")
+            sys.exit(1)
+
+    if any(t < 0 or t > 24 for t in args.mul_trunc) or \
+            any(w < 26 or w > 48 for w in args.add_width):
+        print("Error: --mul-trunc must be in 0..24 and --add-width in 26..48")
+        sys.exit(1)
+    if any(v < 24 or v > 29 for v in args.fwd_width):
+        print("Error: --fwd-width must be in 24..29")
+        sys.exit(1)
+
+    points = [(s, d, e, t, w, v, x, p, f) for s in args.seg_bits for d in args.degree
+              for e in args.engine for t in args.mul_trunc for w in args.add_width
+              for v in args.fwd_width for x in args.fixup for p in pipes
+              for f in args.format
+              if v == 24 or (e == 'fma' and t == 0 and w == 48)]
+    if not points:
+        print("Error: --fwd-width above 24 needs --engine fma, --mul-trunc 0 "
+              "and --add-width 48")
+        sys.exit(1)
+    print(f"{len(points)} design points, {args.jobs} in parallel")
+
+    subprocess.run(['make', '-s', ULPSWEEP], check=True)
+    print("Building the generator...")
+    jar = assembly_jar()
+
+    with concurrent.futures.ThreadPoolExecutor(args.jobs) as pool:
+        fits = {sd: pool.submit(fit_lut, args, *sd)
+                for sd in {pt[:2] for pt in points}}
+        luts = {sd: f.result() for sd, f in fits.items()}
+        print(f"Coefficients ready for {len(luts)} (seg_bits, degree) pairs")
+
+        sweeps = {key: pool.submit(measure_ulp, args, *key, luts[key[:2]])
+                  for key in {pt[:7] for pt in points}}
+        # Sweeps were queued first, so a point waiting on its table never
+        # holds up the sweep it waits for
+        jobs = {pool.submit(evaluate, args, jar, pt, luts[pt[:2]],
+                            sweeps[pt[:7]]): pt
+                for pt in points}
+        rows = []
+        for job in concurrent.futures.as_completed(jobs):
+            try:
+                row = job.result()
+                ulp = sweeps[jobs[job][:7]].result()
+            except RuntimeError as e:
+                print(f"  failed {jobs[job]}: {e}")
+                continue
+            row.update(max_ulp=ulp['max_ulp'], avg_ulp=ulp['avg_ulp'],
+                       fixup_entries=ulp.get('fixup_entries', 0))
+            rows.append(row)
+            print(f"  done {row['point']}")
+
+    if not rows:
+        sys.exit(1)
+    front = pareto(rows)
+    rows.sort(key=lambda r: (r['max_ulp'], r['cells'], r['latency']))
+
+    csv_file = os.path.join(args.out, 'results.csv')
+    with open(csv_file, 'w', newline='') as f:
+        writer = csv.DictWriter(f, fieldnames=list(rows[0]) + ['pareto'])
+        writer.writeheader()
+        for r in rows:
+            writer.writerow({**r, 'pareto': int(r in front)})
+
+    print(f"\n{'':1} {'Point':<52} {'Lat':>4} {'Cells':>8} {'FFs':>6} "
+          f"{'Depth':>6} {'Fixups':>6} {'MaxULP':>8} {'AvgULP':>9}")
+    print('-' * 107)
+    for r in rows:
+        if r in front or args.all:
+            print(f"{'*' if r in front else ' '} {r['point']:<52} {r['latency']:>4} "
+                  f"{r['cells']:>8} {r['ffs']:>6} {r['depth']:>6} {r['fixup_entries']:>6} "
+                  f"{r['max_ulp']:>8} {r['avg_ulp']:>9.2f}")
+    print(f"\n{len(front)} of {len(rows)} points on the Pareto front "
+          f"(* = max ULP, cells, latency)")
+    print_fwd_tradeoff(rows)
+    print(f"Results saved to {csv_file}")
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,218 @@
+#!/usr/bin/env python3
+"""
+Formal proofs of the TANHFP32 handshake pipeline
+
+Usage:
+    python formal.py [options]
+
+Options:
+    --pipe LIST         Pipeline presets, 9-flag strings, 'options' or 'all'
+                        (default: options)
+    --degree LIST       Polynomial degrees (default: 1,2,3)
+    --engine LIST       Horner step engines: fma, muladd (default: fma,muladd)
+    --depth N           Cover depth, 0 for 2 * latency + 4 (default: 0)
+    --jobs N            Configurations checked in parallel (default: CPU count)
+    --out DIR           Work and cache directory (default: build/formal)
+    --force             Re-run every check instead of using cached results
+    --help              Show this help message
+
+For each configuration the driver elaborates the core with TANHFP32Gen
+--tag-width 8 and runs SymbiYosys on formal/TANHFP32_props.sv around it.
+The harness feeds a sequence number in as the tag, so the tags that come
+out show whether the handshakePipeIf chain drops, duplicates or reorders a
+transaction. It also checks that the pipeline holds at most one
+transaction per registered stage, never stalls its input while io_out_ready
+is high, delivers exactly one result per cycle at the expected latency
+while io_out_ready stays high, and never deadlocks. The prove task runs
+PDR, so a pass holds for every input sequence, not only up to a depth. The
+cover task shows that the pipeline really fills up under a stall and then
+drains one result per cycle, so the proof is not vacuous.
+
+No property looks at the result, so Yosys removes the datapath. A LUT of
+zero coefficients stands in for the fitted one. Each configuration is
+cached under --out, keyed by the generator sources (fudian included), the
+harness, and this driver and dse.py, which write the SBY script and the
+expected latency.
+
+Pipeline sets (flags: filter, segment, lut, mul s1-s3, add s1-s2, out):
+    options   all registered, none registered, and each flag alone cleared
+              or alone set (20 configurations)
+    all       every one of the 512 combinations
+    full, lean, min   the presets of dse.py
+
+Examples:
+    # Every pipeline option, all degrees and engines
+    python formal.py --jobs 8
+
+    # Exhaustive over the flags for the committed degree and engine
+    python formal.py --pipe all --degree 2 --engine fma
+"""
+
+import argparse
+import concurrent.futures
+import os
+import re
+import sys
+
+from dse import PIPE_PRESETS, assembly_jar, cached, file_hash, \
+    generator_src, int_list, latency, run, str_list
+
+
+PROPS_SRC = 'formal/TANHFP32_props.sv'
+# Everything besides the generator that a proof result depends on
+FORMAL_SRC = [PROPS_SRC, 'formal.py', 'dse.py']
+TAG_WIDTH = 8
+REGIONS = 64
+
+SBY_SCRIPT = """[tasks]
+prove
+cover
+
+[options]
+prove: mode prove
+cover: mode cover
+cover: depth {depth}
+
+[engines]
+prove: abc pdr
+cover: smtbmc
+
+[script]
+read -formal TANHFP32.sv
+read -formal TANHFP32_props.sv
+chparam -set LATENCY {latency} -set TAG_W {tag_width} TANHFP32_props
+prep -top TANHFP32_props
+
+[files]
+{rtl}
+{props}
+"""
+
+
+def pipe_set(name):
+    if name == 'all':
+        return [format(i, '09b') for i in range(512)]
+    if name == 'options':
+        flags = ['111111111', '000000000']
+        for i in range(9):
+            flags.append('1' * i + '0' + '1' * (8 - i))
+            flags.append('0' * i + '1' + '0' * (8 - i))
+        return flags
+    flags = PIPE_PRESETS.get(name, name)
+    if not re.fullmatch(r'[01]{9}', flags):
+        print(f"Error: '{name}' is neither a pipeline set nor 9 pipe flags")
+        sys.exit(1)
+    return [flags]
+
+
+def zero_lut(args, degree):
+    """Coefficients are outside every property; any values will do"""
+    lut = os.path.join(args.out, 'lut', f'zero_d{degree}.txt')
+    os.makedirs(os.path.dirname(lut), exist_ok=True)
+    with open(lut, 'w') as f:
+        for i in range(REGIONS):
+            f.write(f"{i} {' '.join(['h00000000'] * (degree + 1))}\n")
+    return lut
+
+
+def check(args, jar, config, lut):
+    degree, engine, pipe = config
+    lat = latency(pipe, degree)
+    name = f'd{degree}_{engine}_{pipe}'
+    cdir = os.path.join(args.out, name)
+    os.makedirs(cdir, exist_ok=True)
+    key = ','.join([name, str(args.depth),
+                    file_hash(*generator_src(), *FORMAL_SRC)])
+
+    def prove_and_cover():
+        rtl_dir = os.path.join(cdir, 'rtl')
+        run(['java', '-cp', jar, 'TANHFP32Gen', '--degree', str(degree),
+             '--engine', engine, '--pipe', pipe, '--lut', lut,
+             '--tag-width', str(TAG_WIDTH), '--target-dir', rtl_dir],
+            os.path.join(cdir, 'elaborate.log'))
+        sby = os.path.join(cdir, 'pipeline.sby')
+        with open(sby, 'w') as f:
+            f.write(SBY_SCRIPT.format(
+                depth=args.depth or 2 * lat + 4, latency=lat,
+                tag_width=TAG_WIDTH,
+                rtl=os.path.abspath(os.path.join(rtl_dir, 'TANHFP32.sv')),
+                props=os.path.abspath(PROPS_SRC)))
+        result = {}
+        for task in ('prove', 'cover'):
+            try:
+                run(['sby', '-f', '-d', os.path.join(cdir, task), sby, task],
+                    os.path.join(cdir, task + '.log'))
+                result[task] = 'PASS'
+            except RuntimeError:
+                result[task] = 'FAIL'
+        return result
+
+    result = cached(os.path.join(cdir, 'result.json'), key, args.force,
+                    prove_and_cover)
+    return {'config': name, 'latency': lat, **result}
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description='TANHFP32 handshake pipeline proofs',
+        formatter_class=argparse.RawDescriptionHelpFormatter,
+        epilog=__doc__
+    )
+    parser.add_argument('--pipe', type=str_list, default=['options'],
+                        help='Pipeline sets, presets or flag strings (default: options)')
+    parser.add_argument('--degree', type=int_list, default=[1, 2, 3],
+                        help='Polynomial degrees (default: 1,2,3)')
+    parser.add_argument('--engine', type=str_list, default=['fma', 'muladd'],
+                        help='Horner step engines (default: fma,muladd)')
+    parser.add_argument('--depth', type=int, default=0,
+                        help='Cover depth, 0 for 2 * latency + 4 (default: 0)')
+    parser.add_argument('--jobs', type=int, default=os.cpu_count(),
+                        help='Configurations in parallel (default: CPU count)')
+    parser.add_argument('--out', default='build/formal',
+                        help='Work and cache directory (default: build/formal)')
+    parser.add_argument('--force', action='store_true',
+                        help='Ignore cached results')
+
+    args = parser.parse_args()
+
+    pipes = sorted({flags for p in args.pipe for flags in pipe_set(p)},
+                   reverse=True)
+    if any(d < 1 or d > 3 for d in args.degree) or \
+            any(e not in ('fma', 'muladd') for e in args.engine):
+        print("Error: --degree must be in 1..3 and --engine fma or muladd")
+        sys.exit(1)
+    configs = [(d, e, p) for d in args.degree for e in args.engine for p in pipes]
+    print(f"{len(configs)} configurations, {args.jobs} in parallel")
+
+    print("Building the generator...")
+    jar = assembly_jar()
+
+    luts = {d: zero_lut(args, d) for d in args.degree}
+    rows = []
+    with concurrent.futures.ThreadPoolExecutor(args.jobs) as pool:
+        jobs = {pool.submit(check, args, jar, c, luts[c[0]]): c for c in configs}
+        for job in concurrent.futures.as_completed(jobs):
+            try:
+                row = job.result()
+            except RuntimeError as e:
+                print(f"  failed {jobs[job]}: {e}")
+                row = {'config': 'd{}_{}_{}'.format(*jobs[job]),
+                       'latency': latency(jobs[job][2], jobs[job][0]),
+                       'prove': 'ERROR', 'cover': 'ERROR'}
+            rows.append(row)
+            print(f"  {row['config']:<24} prove {row['prove']:<5} "
+                  f"cover {row['cover']}")
+
+    rows.sort(key=lambda r: r['config'])
+    failed = [r for r in rows if r['prove'] != 'PASS' or r['cover'] != 'PASS']
+    print(f"\n{'Config':<24} {'Lat':>4} {'Prove':>6} {'Cover':>6}")
+    print('-' * 43)
+    for r in failed or rows:
+        print(f"{r['config']:<24} {r['latency']:>4} {r['prove']:>6} {r['cover']:>6}")
+    print(f"\n{len(rows) - len(failed)} of {len(rows)} configurations proved"
+          + (f", logs under {args.out}/<config>" if failed else ""))
+    sys.exit(1 if failed else 0)
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,121 @@
+// Handshake properties of the TANHFP32 pipeline, proved by formal.py.
+//
+// The core is generated with --tag-width TAG_W and fed a running sequence
+// number as its tag. No property looks at the result, so Yosys drops the
+// datapath and only the valid/ready chain and the tag registers are left.
+// With LATENCY registered stages, for any input and io_out_ready sequence:
+//   - results leave in order and once each: every output carries the tag of
+//     the oldest transaction in flight, and nothing leaves an empty pipeline
+//   - at most LATENCY transactions are in flight
+//   - io_out_ready high makes io_in_ready high in the same cycle, so the
+//     pipeline never inserts a bubble of its own
+//   - with io_out_ready high since reset, each transaction leaves exactly
+//     LATENCY cycles after it was accepted: 1/cycle at a fixed latency
+//   - with io_out_ready held high, the oldest transaction leaves within
+//     LATENCY cycles, so the pipeline cannot deadlock
+// With no registered stage the pipeline must be a plain wire.
+
+module TANHFP32_props #(
+  parameter LATENCY = 14,
+  parameter TAG_W   = 8
+) (
+  input        clock,
+  input        reset,
+  input        in_valid,
+  input [31:0] in_bits,
+  input [2:0]  in_rm,
+  input        out_ready
+);
+  wire             in_ready;
+  wire             out_valid;
+  wire [TAG_W-1:0] out_tag;
+  reg  [TAG_W-1:0] in_seq;
+  reg  [TAG_W-1:0] out_seq;
+
+  TANHFP32 dut (
+    .clock           (clock),
+    .reset           (reset),
+    .io_in_ready     (in_ready),
+    .io_in_valid     (in_valid),
+    .io_in_bits_in   (in_bits),
+    .io_in_bits_rm   (in_rm),
+    .io_in_bits_tag  (in_seq),
+    .io_out_ready    (out_ready),
+    .io_out_valid    (out_valid),
+    .io_out_bits_out (),
+    .io_out_bits_tag (out_tag)
+  );
+
+  wire in_fire  = in_valid && in_ready;
+  wire out_fire = out_valid && out_ready;
+
+  // Reset in the first cycle only; every register starts unconstrained
+  reg init = 1'b1;
+  always @(posedge clock)
+    init <= 1'b0;
+  always @(*)
+    assume(reset == init);
+
+  always @(posedge clock) begin
+    if (reset) begin
+      in_seq  <= 0;
+      out_seq <= 0;
+    end else begin
+      in_seq  <= in_seq + in_fire;
+      out_seq <= out_seq + out_fire;
+    end
+  end
+
+  generate
+    if (LATENCY == 0) begin : wire_through
+      always @(*) begin
+        if (!init) begin
+          assert(out_valid == in_valid);
+          assert(in_ready == out_ready);
+          assert(out_tag == in_seq);
+          cover(out_fire);
+        end
+      end
+    end else begin : pipeline
+      reg [TAG_W:0]       count;   // transactions in flight
+      reg [LATENCY-1:0]   history; // bit i: accepted i + 1 cycles ago
+      reg                 flowing; // io_out_ready high in every cycle so far
+      reg [7:0]           waiting; // cycles io_out_ready held without a result
+      reg [7:0]           streak;  // consecutive results
+
+      always @(posedge clock) begin
+        if (reset) begin
+          count   <= 0;
+          history <= 0;
+          flowing <= 1'b1;
+          waiting <= 0;
+          streak  <= 0;
+        end else begin
+          count   <= count + in_fire - out_fire;
+          history <= (history << 1) | in_fire;
+          flowing <= flowing && out_ready;
+          waiting <= out_ready && count != 0 && !out_fire ? waiting + 1 : 0;
+          streak  <= out_fire ? streak + 1 : 0;
+        end
+      end
+
+      always @(*) begin
+        if (!init) begin
+          if (out_valid) begin
+            assert(count != 0);
+            assert(out_tag == out_seq);
+          end
+          assert(count <= LATENCY);
+          if (out_ready)
+            assert(in_ready);
+          if (flowing)
+            assert(out_valid == history[LATENCY-1]);
+          assert(waiting < LATENCY);
+
+          cover(count == LATENCY && !out_ready);
+          cover(streak == LATENCY);
+        end
+      end
+    end
+  endgenerate
+endmodule
@@ -0,0 +1,100 @@
+#!/usr/bin/env python3
+"""
+Render a pipeline trace written by the pipeline profiler
+
+Usage:
+    python plot_pipeline.py [options]
+
+Options:
+    --input FILE        Trace file (default: build/pipeprof/pipe_trace.txt)
+    --output FILE       Output image file (default: build/pipeprof/pipe_trace.png)
+    --start N           First cycle to draw (default: 0)
+    --cycles N          Number of cycles to draw (default: 200)
+    --help              Show this help message
+
+The trace has one line per cycle and one character per column (io.in, each
+pipeline stage, io.out):
+    .   empty / not valid
+    =   holds a transaction that moves on this cycle
+    S   valid but stalled by the downstream ready
+    >   port handshake fires
+
+Examples:
+    # Capture a trace under 30% output backpressure, then draw it
+    make pipeprof PIPEPROF_ARGS="--backpressure 0.3"
+    python plot_pipeline.py --cycles 100
+"""
+
+import argparse
+import sys
+import matplotlib.pyplot as plt
+from matplotlib.colors import ListedColormap
+import numpy as np
+
+
+STATE_CODES = {'.': 0, '=': 1, '>': 2, 'S': 3}
+STATE_COLORS = ['#f0f0f0', '#4c9be8', '#2ca02c', '#d62728']
+STATE_LABELS = ['empty', 'moving', 'fire', 'stall']
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description='Render a pipeline trace',
+        formatter_class=argparse.RawDescriptionHelpFormatter,
+        epilog=__doc__
+    )
+    parser.add_argument('--input', default='build/pipeprof/pipe_trace.txt',
+                        help='Trace file (default: build/pipeprof/pipe_trace.txt)')
+    parser.add_argument('--output', default='build/pipeprof/pipe_trace.png',
+                        help='Output image file (default: build/pipeprof/pipe_trace.png)')
+    parser.add_argument('--start', type=int, default=0,
+                        help='First cycle to draw (default: 0)')
+    parser.add_argument('--cycles', type=int, default=200,
+                        help='Number of cycles to draw (default: 200)')
+
+    args = parser.parse_args()
+
+    try:
+        with open(args.input) as f:
+            header = f.readline()
+            lines = f.read().split()
+    except FileNotFoundError:
+        print(f"Error: File '{args.input}' not found")
+        print("Please run 'make pipeprof' first to generate the trace")
+        sys.exit(1)
+
+    if not header.startswith('# stages:'):
+        print(f"Error: '{args.input}' is not a pipeline trace")
+        sys.exit(1)
+    columns = header.split(':', 1)[1].split()
+
+    window = lines[args.start:args.start + args.cycles]
+    if not window:
+        print(f"Error: Trace has only {len(lines)} cycles")
+        sys.exit(1)
+    print(f"Drawing cycles {args.start}..{args.start + len(window) - 1} "
+          f"of {len(lines)}")
+
+    grid = np.array([[STATE_CODES.get(c, 0) for c in line] for line in window]).T
+
+    fig_w = min(max(len(window) * 0.08, 6), 30)
+    plt.figure(figsize=(fig_w, len(columns) * 0.35 + 1.5))
+    plt.imshow(grid, aspect='auto', interpolation='nearest',
+               cmap=ListedColormap(STATE_COLORS), vmin=0, vmax=3,
+               extent=(args.start - 0.5, args.start + len(window) - 0.5,
+                       len(columns) - 0.5, -0.5))
+    plt.yticks(range(len(columns)), columns, fontsize=8)
+    plt.xlabel('Cycle', fontsize=12)
+    plt.title('TANHFP32 Pipeline Occupancy', fontsize=14)
+
+    handles = [plt.Rectangle((0, 0), 1, 1, color=c) for c in STATE_COLORS]
+    plt.legend(handles, STATE_LABELS, loc='upper left',
+               bbox_to_anchor=(1.0, 1.0), fontsize=8)
+
+    plt.tight_layout()
+    plt.savefig(args.output, dpi=150, bbox_inches='tight')
+    print(f"Plot saved to {args.output}")
+
+
+if __name__ == '__main__':
+    main()
@@ -1,18 +1,23 @@
 #!/usr/bin/env python3
 """
-Plot TANH test results from random_cases.csv
+Plot TANH test results from random_cases.csv, or the binned error
+heatmaps the testbench writes for any run size
 
 Usage:
     python plot_results.py [options]
 
 Options:
     --input FILE        Input CSV file (default: build/random_cases.csv)
-    --output FILE       Output image file (default: build/tanh_plot.png)
+    --output FILE       Output image file (default: build/tanh_plot.png,
+                        build/heatmap.png with --heatmap)
     --plot CURVES       Comma-separated list of curves to plot
-                        Options: dut, cpu_ref, gpu_ref
+                        Options: dut and one <label>_ref column per
+                        --ref of the run (cpu_ref, gpu_ref, cr_ref, ...)
                         Examples: dut,cpu_ref  or  dut  or  cpu_ref,gpu_ref
                         Default: dut,cpu_ref
     --sample N          Plot only every N-th point (default: 100)
+    --heatmap PREFIX    Render PREFIX_ulp.npy and PREFIX_serr.npy instead of
+                        the CSV (the testbench writes build/heatmap_*.npy)
     --help              Show this help message
 
 Examples:
@@ -27,15 +32,99 @@ Examples:
 
     # Plot with custom sampling
     python plot_results.py --plot dut,cpu_ref --sample 1000
+
+    # Error heatmaps of the last random run, or of an exhaustive sweep
+    python plot_results.py --heatmap build/heatmap
+    python plot_results.py --heatmap build/sweep/heatmap
+
+Heatmap columns bucket |x| by exponent and the top 3 mantissa bits; rows
+bucket the error by powers of two. Every vector is counted, so isolated
+large-ULP inputs stay visible.
 """
 
 import argparse
 import sys
-import pandas as pd
 import matplotlib.pyplot as plt
+from matplotlib.colors import LogNorm
 import numpy as np
 
 
+# Must match HIST_MANT_BITS in sim-verilator/TANHFP32_stats.h
+HIST_MANT_BITS = 3
+
+
+def error_bucket_label(m):
+    """Label of magnitude bucket m: 0, or [2^(m-1), 2^m)"""
+    if m == 0:
+        return '0'
+    if m <= 3:
+        lo, hi = 1 << (m - 1), (1 << m) - 1
+        return str(lo) if lo == hi else f'{lo}-{hi}'
+    return f'2^{m - 1}'
+
+
+def x_ticks(lo, hi):
+    """Column ticks at exponent boundaries between columns lo and hi"""
+    per_exp = 1 << HIST_MANT_BITS
+    exps = range((lo + per_exp - 1) // per_exp, hi // per_exp + 1)
+    step = max(1, len(exps) // 16)
+    ticks, labels = [], []
+    for e in exps[::step]:
+        ticks.append(e * per_exp - lo)
+        labels.append('Inf/NaN' if e == 255 else
+                      '0/sub' if e == 0 else f'2^{e - 127}')
+    return ticks, labels
+
+
+def plot_heatmap(prefix, output):
+    try:
+        ulp = np.load(f'{prefix}_ulp.npy')
+        serr = np.load(f'{prefix}_serr.npy')
+    except FileNotFoundError as e:
+        print(f"Error: File '{e.filename}' not found")
+        print("Please run the simulation first to generate the heatmaps")
+        sys.exit(1)
+    print(f"Loaded heatmaps of {int(ulp.sum())} vectors from {prefix}_*.npy")
+
+    # Crop to the input columns and error rows that were hit
+    cols = np.nonzero(ulp.sum(axis=0))[0]
+    if len(cols) == 0:
+        print("Error: Heatmaps are empty")
+        sys.exit(1)
+    c0, c1 = cols[0], cols[-1] + 1
+    zero_row = ulp.shape[0] - 1
+    max_mag = max(np.nonzero(ulp.sum(axis=1))[0][-1], 1)
+
+    ulp = ulp[:max_mag + 1, c0:c1]
+    serr = serr[zero_row - max_mag:zero_row + max_mag + 1, c0:c1]
+    ulp_labels = [error_bucket_label(m) for m in range(max_mag + 1)]
+    serr_labels = ([f'-{error_bucket_label(m)}' for m in range(max_mag, 0, -1)] +
+                   ['0'] + [f'+{error_bucket_label(m)}' for m in range(1, max_mag + 1)])
+
+    fig, axes = plt.subplots(2, 1, figsize=(14, 10))
+    ticks, tick_labels = x_ticks(c0, c1)
+    panels = [(axes[0], ulp, ulp_labels, 'ULP error'),
+              (axes[1], serr, serr_labels, 'Signed error (DUT - ref, ULP)')]
+    for ax, data, labels, title in panels:
+        masked = np.ma.masked_equal(data, 0)
+        im = ax.imshow(masked, aspect='auto', origin='lower',
+                       interpolation='nearest', cmap='viridis',
+                       norm=LogNorm(vmin=1, vmax=max(data.max(), 1)))
+        step = max(1, len(labels) // 16)
+        ax.set_yticks(range(0, len(labels), step))
+        ax.set_yticklabels(labels[::step], fontsize=8)
+        ax.set_xticks(ticks)
+        ax.set_xticklabels(tick_labels, fontsize=8)
+        ax.set_xlabel('|x|', fontsize=12)
+        ax.set_ylabel(title, fontsize=12)
+        fig.colorbar(im, ax=ax, label='Vectors')
+    axes[0].set_title('TANH Error Heatmaps', fontsize=14)
+
+    plt.tight_layout()
+    plt.savefig(output, dpi=150, bbox_inches='tight')
+    print(f"Plot saved to {output}")
+
+
 def main():
     parser = argparse.ArgumentParser(
         description='Plot TANH test results',
@@ -44,15 +133,25 @@ def main():
     )
     parser.add_argument('--input', default='build/random_cases.csv',
                         help='Input CSV file (default: build/random_cases.csv)')
-    parser.add_argument('--output', default='build/tanh_plot.png',
+    parser.add_argument('--output', default=None,
                         help='Output image file (default: build/tanh_plot.png)')
     parser.add_argument('--plot', default='dut,cpu_ref',
                         help='Comma-separated curves to plot (default: dut,cpu_ref)')
     parser.add_argument('--sample', type=int, default=100,
                         help='Plot every N-th point (default: 100)')
+    parser.add_argument('--heatmap', metavar='PREFIX',
+                        help='Render the binned error heatmaps at PREFIX')
 
     args = parser.parse_args()
 
+    if args.heatmap:
+        plot_heatmap(args.heatmap, args.output or 'build/heatmap.png')
+        return
+    args.output = args.output or 'build/tanh_plot.png'
+
+    # Only the CSV path needs pandas, and importing it is slow
+    import pandas as pd
+
     # Read CSV file
     try:
         df = pd.read_csv(args.input)
@@ -0,0 +1,131 @@
+#!/usr/bin/env python3
+"""
+Measure simulator rebuild times of the flat and hierarchical builds
+
+Usage:
+    python rebuild_time.py [options]
+
+Options:
+    --output FILE       Timings as JSON (default: build/rebuild.json)
+    --jobs N            HIER_JOBS for the hierarchical build (default: nproc)
+    --help              Show this help message
+
+Runs, for the flat build (make build/TANHFP32_sim) and the hierarchical one
+(make build/hier/TANHFP32_sim):
+    clean   from an empty object directory
+    touch   after regenerating identical RTL (a Scala edit that only moves
+            source lines)
+    lut     after changing one LUT coefficient in rtl/TANHFP32.sv, the
+            edit a new lut.txt makes
+
+The RTL edits are made on rtl/TANHFP32.sv directly so mill is not part of
+the timing; the original file is restored afterwards. The JSON keys end in
+'_s', so two runs can be compared with bench_compare.py.
+
+Examples:
+    make rebuild-time
+    python bench_compare.py old_rebuild.json build/rebuild.json
+"""
+
+import argparse
+import json
+import os
+import re
+import shutil
+import subprocess
+import sys
+import time
+
+
+VSRC = 'rtl/TANHFP32.sv'
+BUILDS = {
+    'flat': {'target': 'build/TANHFP32_sim', 'dirs': ['build/obj_dir']},
+    'hier': {'target': 'build/hier/TANHFP32_sim', 'dirs': ['build/hier']},
+}
+
+
+def timed_make(target, jobs):
+    # Empty SCALA_SRC keeps mill out of it even if the Scala source is newer
+    cmd = ['make', target, 'SCALA_SRC=']
+    if jobs:
+        cmd.append(f'HIER_JOBS={jobs}')
+    t0 = time.monotonic()
+    proc = subprocess.run(cmd, stdout=subprocess.DEVNULL, stderr=subprocess.PIPE,
+                          text=True)
+    elapsed = time.monotonic() - t0
+    if proc.returncode != 0:
+        print(proc.stderr)
+        raise RuntimeError(f"'{' '.join(cmd)}' failed")
+    return elapsed
+
+
+def edit_coefficient(path):
+    with open(path) as f:
+        text = f.read()
+    # Flip the last bit of the first LUT constant
+    m = re.search(r"32'h([0-9A-F]{8})", text[text.index('module LUTTanh('):])
+    if not m:
+        raise RuntimeError(f'no LUT constant found in {path}')
+    old = m.group(0)
+    new = "32'h%08X" % (int(m.group(1), 16) ^ 1)
+    with open(path, 'w') as f:
+        f.write(text.replace(old, new, 1))
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description='Measure simulator rebuild times',
+        formatter_class=argparse.RawDescriptionHelpFormatter,
+        epilog=__doc__
+    )
+    parser.add_argument('--output', default='build/rebuild.json',
+                        help='Timings as JSON (default: build/rebuild.json)')
+    parser.add_argument('--jobs', type=int, default=None,
+                        help='HIER_JOBS for the hierarchical build')
+
+    args = parser.parse_args()
+
+    if not os.path.exists(VSRC):
+        print(f"Error: File '{VSRC}' not found")
+        sys.exit(1)
+
+    backup = VSRC + '.orig'
+    shutil.copy2(VSRC, backup)
+    results = {}
+    try:
+        for name, build in BUILDS.items():
+            for d in build['dirs']:
+                shutil.rmtree(d, ignore_errors=True)
+            if os.path.exists(build['target']):
+                os.remove(build['target'])
+            print(f"{name}: clean build...")
+            results[f'{name}_clean_s'] = timed_make(build['target'], args.jobs)
+
+        for edit in ['touch', 'lut']:
+            shutil.copy2(backup, VSRC)
+            if edit == 'lut':
+                edit_coefficient(VSRC)
+            os.utime(VSRC)
+            for name, build in BUILDS.items():
+                print(f"{name}: rebuild after {edit}...")
+                results[f'{name}_{edit}_s'] = timed_make(build['target'], args.jobs)
+    finally:
+        shutil.move(backup, VSRC)
+        os.utime(VSRC)
+
+    print(f"\n{'Rebuild':<8} {'Flat (s)':>10} {'Hier (s)':>10} {'Speedup':>8}")
+    print('-' * 40)
+    for kind in ['clean', 'touch', 'lut']:
+        flat, hier = results[f'flat_{kind}_s'], results[f'hier_{kind}_s']
+        print(f"{kind:<8} {flat:>10.1f} {hier:>10.1f} {flat / hier:>7.2f}x")
+
+    os.makedirs(os.path.dirname(args.output), exist_ok=True)
+    with open(args.output, 'w') as f:
+        json.dump(results, f, indent=2)
+    print(f"\nTimings saved to {args.output}")
+    print("Both simulators were last built from an edited RTL; "
+          "the next make rebuilds them from the restored file")
+
+
+if __name__ == '__main__':
+    main()
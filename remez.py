@@ -1,3 +1,30 @@
+#!/usr/bin/env python3
+"""
+Fit minimax polynomial coefficients for the TANHFP32 lookup table
+
+Usage:
+    python remez.py [options]
+
+Options:
+    --seg-bits N        Mantissa bits of the segment index (default: 3)
+    --degree N          Polynomial degree (default: 2)
+    --output FILE       Output coefficient file (default: lut.txt)
+    --help              Show this help message
+
+[2^-5, 8) is split into 8 octaves of 2^N segments each; every output line
+is the segment index followed by c0 .. c<degree>. The defaults produce the
+committed lut.txt; other values must match the generator's --seg-bits and
+--degree.
+
+Examples:
+    # Regenerate lut.txt
+    python remez.py
+
+    # Cubic over 16 segments per octave
+    python remez.py --seg-bits 4 --degree 3 --output build/lut_s4_d3.txt
+"""
+
+import argparse
 import numpy as np
 from scipy.optimize import differential_evolution
 import struct
@@ -6,22 +33,23 @@ def float_to_hex(f):
     hex_str = hex(struct.unpack('>I', struct.pack('>f', f))[0])
     return hex_str.replace('0x', 'h')  # 改为 Chisel 格式 h
 
-def generate_segments_3bit():
+def generate_segments(seg_bits):
     segments = {}
     x_min, x_max = 2**(-5), 8.0
+    per_exp = 1 << seg_bits
     
     for exp in range(-5, 3):
         exp_val = 2.0 ** exp
         e_off = exp + 5
         
-        for mant_idx in range(8):
-            mant_start = mant_idx / 8.0
-            mant_end = (mant_idx + 1) / 8.0
+        for mant_idx in range(per_exp):
+            mant_start = mant_idx / per_exp
+            mant_end = (mant_idx + 1) / per_exp
             
             a = exp_val * (1.0 + mant_start)
             b = exp_val * (1.0 + mant_end)
             
-            region_idx = (e_off << 3) | mant_idx
+            region_idx = (e_off << seg_bits) | mant_idx
             
             if b <= x_min or a >= x_max:
                 segments[region_idx] = None
@@ -37,23 +65,23 @@ def generate_segments_3bit():
     
     return segments
 
-def minimax_fit(a, b):
+def poly_eval(c, x):
+    return sum(c[k] * x**k for k in range(len(c)))
+
+def minimax_fit(a, b, degree):
     x_init = np.linspace(a, b, 500)
     y_init = np.tanh(x_init)
-    A = np.vstack([np.ones_like(x_init), x_init, x_init**2]).T
+    A = np.vstack([x_init**k for k in range(degree + 1)]).T
     c_init = np.linalg.lstsq(A, y_init, rcond=None)[0]
     
     def objective(c):
         x_dense = np.linspace(a, b, 3000)
         y_true = np.tanh(x_dense)
-        y_approx = c[0] + c[1]*x_dense + c[2]*x_dense**2
+        y_approx = poly_eval(c, x_dense)
         return np.max(np.abs(y_true - y_approx))
     
-    bounds = [
-        (c_init[0] - 0.1, c_init[0] + 0.1),
-        (c_init[1] - 0.2, c_init[1] + 0.2),
-        (c_init[2] - 0.2, c_init[2] + 0.2)
-    ]
+    bounds = [(c_init[0] - 0.1, c_init[0] + 0.1)] + \
+             [(c_init[k] - 0.2, c_init[k] + 0.2) for k in range(1, degree + 1)]
     
     result = differential_evolution(
         objective,
@@ -70,47 +98,40 @@ def minimax_fit(a, b):
     
     return result.x
 
-def compute_coefficients():
-    segments = generate_segments_3bit()
+def compute_coefficients(seg_bits, degree):
+    segments = generate_segments(seg_bits)
+    n_segments = 8 << seg_bits
     target = 2**(-12)
     
     results = {}
     max_errors = []
     valid_count = 0
     
-    print(f"Total segments: 64")
+    print(f"Total segments: {n_segments}")
     
-    for idx in range(64):
+    for idx in range(n_segments):
         if segments[idx] is None:
-            results[idx] = {
-                'c0': 0.0,
-                'c1': 0.0,
-                'c2': 0.0
-            }
+            results[idx] = [0.0] * (degree + 1)
             continue
         
         valid_count += 1
         a, b = segments[idx]
         
-        c = minimax_fit(a, b)
+        c = minimax_fit(a, b, degree)
         
         x_test = np.linspace(a, b, 10000)
         y_true = np.tanh(x_test)
-        y_approx = c[0] + c[1]*x_test + c[2]*x_test**2
+        y_approx = poly_eval(c, x_test)
         max_err = np.max(np.abs(y_true - y_approx))
         max_errors.append(max_err)
         
-        results[idx] = {
-            'c0': c[0],
-            'c1': c[1],
-            'c2': c[2]
-        }
+        results[idx] = list(c)
         
         if valid_count % 10 == 0:
             print(f"  Valid segments: {valid_count}")
     
     overall_max = max(max_errors) if max_errors else 0
-    print(f"\nValid segments: {valid_count}/64")
+    print(f"\nValid segments: {valid_count}/{n_segments}")
     print(f"Max error: {overall_max:.10e}")
     print(f"Target:    {target:.10e}")
     print(f"Status:    {'PASS' if overall_max < target else 'FAIL'}")
@@ -118,18 +139,29 @@ def compute_coefficients():
     return results
 
 def save_to_file(results, filename="lut.txt"):
+    n_coeffs = len(results[0])
     with open(filename, 'w') as f:
-        for idx in range(64):
-            r = results[idx]
-            c0_hex = float_to_hex(r['c0'])
-            c1_hex = float_to_hex(r['c1'])
-            c2_hex = float_to_hex(r['c2'])
-            f.write(f"{idx} {c0_hex} {c1_hex} {c2_hex}\n")
+        for idx in range(len(results)):
+            coeffs = ' '.join(float_to_hex(c) for c in results[idx])
+            f.write(f"{idx} {coeffs}\n")
     
     print(f"\nSaved to {filename}")
-    print(f"Entries: 64")
-    print(f"Size: {64 * 3 * 4} bytes")
+    print(f"Entries: {len(results)}")
+    print(f"Size: {len(results) * n_coeffs * 4} bytes")
 
 if __name__ == "__main__":
-    results = compute_coefficients()
-    save_to_file(results, "lut.txt")
+    parser = argparse.ArgumentParser(
+        description='Fit TANHFP32 lookup table coefficients',
+        formatter_class=argparse.RawDescriptionHelpFormatter,
+        epilog=__doc__
+    )
+    parser.add_argument('--seg-bits', type=int, default=3,
+                        help='Mantissa bits of the segment index (default: 3)')
+    parser.add_argument('--degree', type=int, default=2,
+                        help='Polynomial degree (default: 2)')
+    parser.add_argument('--output', default='lut.txt',
+                        help='Output coefficient file (default: lut.txt)')
+    args = parser.parse_args()
+    
+    results = compute_coefficients(args.seg_bits, args.degree)
+    save_to_file(results, args.output)
@@ -1,261 +1,242 @@
+#include "TANHFP32_cov.h"
+#include "TANHFP32_model.h"
+#include "TANHFP32_pipeprof.h"
+#include "TANHFP32_refset.h"
+#include "TANHFP32_regprof.h"
+#include "TANHFP32_seq.h"
+#include "TANHFP32_stats.h"
+#include "TANHFP32_tb.h"
 #include <VTANHFP32.h>
 #include <cfloat>
 #include <cmath>
 #include <cstdint>
 #include <cstdio>
 #include <cstdlib>
+#include <cstring>
 #include <ctime>
+#include <getopt.h>
+#include <thread>
 #include <verilated.h>
-#include <verilated_fst_c.h>
 
-#define CONFIG_WAVE_TRACE
+#define MAX_ENVS 64
+
+// Independent environments of the run, each with its own DUT. The random
+// run and the exhaustive sweep split their vectors across all of them; the
+// special cases, coverage and sequential runs use the first.
+static tb_env envs[MAX_ENVS];
+static int env_count = 1;
+static char wave_files[MAX_ENVS][32];
+
+// Phases the test functions time themselves; each environment times its
+// own batches, folded in by collect_env_phases
+static double phase_time[TB_PHASE_NUM];
+static double phase_start;
+static uint64_t drive_cycles = 0;
+static uint64_t drive_results = 0;
+static uint64_t total_cycles = 0;
+static bool print_failures = true;
+// Probability that io_out_ready is low in a given cycle
+static double backpressure = 0.0;
+static bool coverage = false;
+// Hits of the whole campaign, merged from the environments between rounds
+static cov_db coverage_total;
+static const char *heatmap_prefix = "build/heatmap";
+static const ref_provider *ref_list[REF_SET_MAX];
+static int ref_count = 0;
+static int ref_threads = 0;
+// Software model of the DUT for the model reference and the sweep's
+// bit-exact check; every environment gets its own copy
+static tanh_model model;
+static bool model_loaded = false;
+// Primary-reference bound of --max-ulp, -1 for none
+static int64_t max_ulp = -1;
+// Set by every check that fails the run; main's exit status
+static bool run_failed = false;
+
+static uint32_t float_bits(float f) {
+  uint32_t u;
+  memcpy(&u, &f, sizeof(u));
+  return u;
+}
 
-#ifdef __USE_GPU_REF__
-extern "C" void tanh_nvidia_batch(float *vin, float *golden, int n);
-#endif
+static float bits_float(uint32_t u) {
+  float f;
+  memcpy(&f, &u, sizeof(f));
+  return f;
+}
 
-static VerilatedContext *contextp = NULL;
-static VerilatedFstC *tfp = NULL;
-static VTANHFP32 *top = NULL;
-static uint64_t cycle_count = 0;
-#define RESET (top->reset)
-#define CLOCK (top->clock)
+static void phase_begin() { phase_start = tb_now(); }
 
-void single_cycle() {
-  CLOCK = 0;
-  top->eval();
-#ifdef CONFIG_WAVE_TRACE
-  tfp->dump(contextp->time());
-  contextp->timeInc(1);
-#endif
-  CLOCK = 1;
-  top->eval();
-#ifdef CONFIG_WAVE_TRACE
-  tfp->dump(contextp->time());
-  contextp->timeInc(1);
-#endif
-  cycle_count++;
-}
+static void phase_end(int phase) { phase_time[phase] += tb_now() - phase_start; }
 
-void reset(int n) {
-  RESET = 1;
-  while (n-- > 0)
-    single_cycle();
-  RESET = 0;
+// Environments run concurrently, so a phase costs the slowest one's time;
+// they are initialized one after another, so init costs the sum
+static void collect_env_phases() {
+  for (int p = 0; p < TB_PHASE_NUM; p++) {
+    double t = 0.0;
+    for (int e = 0; e < env_count; e++) {
+      double et = envs[e].phase_time[p];
+      t = p == TB_PHASE_INIT ? t + et : et > t ? et : t;
+    }
+    phase_time[p] += t;
+  }
+  for (int e = 0; e < env_count; e++) {
+    drive_cycles += envs[e].drive_cycles;
+    drive_results += envs[e].results;
+    total_cycles += envs[e].sim.cycles;
+  }
 }
 
-void sim_init() {
-  contextp = new VerilatedContext;
-  top = new VTANHFP32{contextp};
-#ifdef CONFIG_WAVE_TRACE
-  tfp = new VerilatedFstC;
-  contextp->traceEverOn(true);
-  top->trace(tfp, 0);
-  tfp->open("build/wave.fst");
+#if defined(CONFIG_PIPE_PROFILE) || defined(CONFIG_REG_PROFILE)
+static void profile_cycle(tb_env *env, bool draining) {
+#ifdef CONFIG_PIPE_PROFILE
+  pipeprof_sample(env->sim.top->io_in_valid, env->sim.top->io_out_ready,
+                  draining);
 #endif
-  reset(10);
-}
-
-void sim_exit() {
-#ifdef CONFIG_WAVE_TRACE
-  tfp->close();
-  delete tfp;
+#ifdef CONFIG_REG_PROFILE
+  regprof_sample();
 #endif
-  delete top;
-  delete contextp;
 }
+#endif
 
-void compute_reference(float *vin, float *cpu_ref, float *gpu_ref, int n) {
-  for (int i = 0; i < n; i++) {
-    cpu_ref[i] = tanhf(vin[i]);
-  }
-
-#ifdef __USE_GPU_REF__
-  tanh_nvidia_batch(vin, gpu_ref, n);
-#else
-  for (int i = 0; i < n; i++) {
-    gpu_ref[i] = cpu_ref[i];
+static void envs_init(int batch, unsigned seed) {
+  // Share the reference threads between environments that check at once
+  int threads = ref_threads > 0 ? ref_threads
+                                : (int)std::thread::hardware_concurrency();
+  threads = threads / env_count > 1 ? threads / env_count : 1;
+  for (int e = 0; e < env_count; e++) {
+    tb_env_config cfg;
+    cfg.id = e;
+    cfg.refs = ref_list;
+    cfg.ref_count = ref_count;
+    cfg.ref_threads = env_count > 1 ? threads : ref_threads;
+    cfg.batch = batch;
+    cfg.backpressure = backpressure;
+    cfg.seed = seed + e;
+    cfg.print_failures = print_failures;
+    if (e == 0)
+      snprintf(wave_files[e], sizeof(wave_files[e]), "build/wave.fst");
+    else
+      snprintf(wave_files[e], sizeof(wave_files[e]), "build/wave_%d.fst", e);
+    cfg.wave_file = wave_files[e];
+    cfg.model = model_loaded ? &model : NULL;
+    tb_env_init(&envs[e], &cfg);
   }
-#endif
 }
 
-uint64_t compute_ulp(float golden, float hardware) {
-  union {
-    float f;
-    uint32_t u;
-  } g, h;
-  g.f = golden;
-  h.f = hardware;
-
-  if (std::isnan(g.f) && std::isnan(h.f))
-    return 0;
-  if (std::isinf(g.f) && std::isinf(h.f) &&
-      ((g.u & 0x80000000) == (h.u & 0x80000000)))
-    return 0;
-  if (g.f == h.f)
-    return 0;
-
-  bool g_neg = (g.u >> 31) & 1;
-  bool h_neg = (h.u >> 31) & 1;
-
-  if (g_neg != h_neg) {
-    uint32_t g_mag = g.u & 0x7FFFFFFF;
-    uint32_t h_mag = h.u & 0x7FFFFFFF;
-    return (uint64_t)g_mag + (uint64_t)h_mag;
+// The model reference is bit-exact, so any distance from it is an RTL bug.
+// With bound, the primary reference also fails the run above --max-ulp.
+static void check_ref_stats(const ref_set *const *sets, int n, bool bound) {
+  for (int r = 0; r < sets[0]->n; r++) {
+    error_stats sum;
+    memset(&sum, 0, sizeof(sum));
+    for (int s = 0; s < n; s++)
+      error_stats_merge(&sum, &sets[s]->stats[r]);
+    const ref_provider *p = sets[0]->provider[r];
+    if (p->model_batch && sum.max_ulp > 0) {
+      printf("Error: DUT differs from %s by up to %lu ULP\n", p->label,
+             sum.max_ulp);
+      run_failed = true;
+    } else if (bound && r == 0 && max_ulp >= 0 &&
+               sum.max_ulp > (uint64_t)max_ulp) {
+      printf("Error: Max ULP %lu against %s is above --max-ulp %ld\n",
+             sum.max_ulp, p->label, max_ulp);
+      run_failed = true;
+    }
   }
+}
 
-  if (g.u > h.u)
-    return (uint64_t)(g.u - h.u);
-  else
-    return (uint64_t)(h.u - g.u);
+static void check_env_stats() {
+  const ref_set *sets[MAX_ENVS];
+  for (int e = 0; e < env_count; e++)
+    sets[e] = &envs[e].sb.refs;
+  check_ref_stats(sets, env_count, true);
 }
 
-void drive_dut(float *vin, float *vout, int n) {
-  int issued = 0;
-  int received = 0;
-  top->io_out_ready = 1;
-  top->io_in_valid = 0;
-
-  while (received < n) {
-    if (issued < n && top->io_in_ready) {
-      union {
-        float f;
-        uint32_t u;
-      } conv;
-      conv.f = vin[issued];
-      top->io_in_valid = 1;
-      top->io_in_bits_in = conv.u;
-      top->io_in_bits_rm = 0;
-      issued++;
-    } else {
-      top->io_in_valid = 0;
-    }
-    single_cycle();
-    if (top->io_out_valid) {
-      union {
-        float f;
-        uint32_t u;
-      } out;
-      out.u = top->io_out_bits_out;
-      vout[received] = out.f;
-      received++;
-    }
-  }
+static void envs_free() {
+  for (int e = 0; e < env_count; e++)
+    tb_env_free(&envs[e]);
 }
 
-void save_data_to_csv(const char *filename, float *vin, float *dut,
-                      float *cpu_ref, float *gpu_ref, int n) {
-  printf("Saving data to %s...\n", filename);
+void save_bench_json(const char *filename, double build_time, unsigned seed) {
+  printf("Saving benchmark results to %s...\n", filename);
   FILE *fp = fopen(filename, "w");
   if (!fp) {
-    printf("Warning: Failed to save data file.\n");
+    printf("Warning: Failed to save benchmark file.\n");
     return;
   }
 
-  fprintf(fp, "in,dut,cpu_ref");
-#ifdef __USE_GPU_REF__
-  fprintf(fp, ",gpu_ref");
-#endif
-  fprintf(fp, "\n");
-
-  for (int i = 0; i < n; i++) {
-    fprintf(fp, "%.9e,%.9e,%.9e", vin[i], dut[i], cpu_ref[i]);
-#ifdef __USE_GPU_REF__
-    fprintf(fp, ",%.9e", gpu_ref[i]);
-#endif
-    fprintf(fp, "\n");
+  double total = 0.0;
+  fprintf(fp, "{\n");
+  if (build_time >= 0.0)
+    fprintf(fp, "  \"build_s\": %.6f,\n", build_time);
+  for (int i = 0; i < TB_PHASE_NUM; i++) {
+    fprintf(fp, "  \"%s_s\": %.6f,\n", tb_phase_name[i], phase_time[i]);
+    total += phase_time[i];
   }
+  fprintf(fp, "  \"total_s\": %.6f,\n", total);
+  fprintf(fp, "  \"sim_cycles_per_s\": %.1f,\n",
+          drive_cycles / phase_time[TB_PHASE_DRIVE]);
+  fprintf(fp, "  \"results_per_cycle\": %.6f,\n",
+          (double)drive_results / drive_cycles);
+  fprintf(fp, "  \"drive_cycles\": %lu,\n", drive_cycles);
+  fprintf(fp, "  \"results\": %lu,\n", drive_results);
+  fprintf(fp, "  \"seed\": %u\n", seed);
+  fprintf(fp, "}\n");
 
   fclose(fp);
-  printf("Data saved successfully.\n");
 }
 
-void compute_error_stats(float *vin, float *dut, float *ref, int n,
-                         double err_threshold, uint64_t ulp_threshold,
-                         bool print_failures, const char *ref_name) {
-  int pass = 0, fail = 0;
-  double total_err = 0.0, max_err = 0.0;
-  uint64_t total_ulp = 0, max_ulp = 0;
-
-  if (print_failures) {
-    printf("\n%13s %13s %13s %13s %13s\n", "Input", "Reference", "DUT", "Error",
-           "ULP");
-    printf(
-        "---------------------------------------------------------------------"
-        "----\n");
-  }
-
-  for (int i = 0; i < n; i++) {
-    double g = (double)ref[i];
-    double h = (double)dut[i];
-    double err;
-    uint64_t ulp = compute_ulp(ref[i], dut[i]);
-
-    if (std::isnan(g) && std::isnan(h)) {
-      err = 0.0;
-    } else if (std::isinf(g) && std::isinf(h)) {
-      err = 0.0;
-    } else {
-      err = fabs((h - g) / ((g == 0.0 || h == 0.0) ? 1.0 : g));
-    }
-
-    total_err += err;
-    total_ulp += ulp;
-    if (err > max_err)
-      max_err = err;
-    if (ulp > max_ulp)
-      max_ulp = ulp;
-
-    if ((std::isnan(g) && std::isnan(h)) || (std::isinf(g) && std::isinf(h))) {
-      pass++;
-    } else if (err < err_threshold && ulp <= ulp_threshold) {
-      pass++;
-    } else {
-      fail++;
-      if (print_failures) {
-        printf("%+13.6e %+13.6e %+13.6e %13.6e %13lu\n", vin[i], ref[i], dut[i],
-               err, ulp);
-      }
-    }
-  }
+// Size of the fixed random run, and what --seq reports its saving against
+#define RANDOM_N 1000000
 
-  printf("\n=== %s Statistics ===\n", ref_name);
-  printf("Total=%d, Pass=%d (%.2f%%), Fail=%d (%.2f%%)\n", n, pass,
-         (pass * 100.0 / n), fail, (fail * 100.0 / n));
-  printf("AvgErr=%e, MaxErr=%e\n", total_err / n, max_err);
-  printf("AvgULP=%.2f, MaxULP=%lu\n", (double)total_ulp / n, max_ulp);
+static void print_failure_header() {
+  printf("\n%13s %13s %13s %13s %13s\n", "Input", "Reference", "DUT", "Error",
+         "ULP");
+  printf("---------------------------------------------------------------------"
+         "----\n");
 }
 
-static void test_random_cases() {
-  const int N = 1000000;
-  float *vin = (float *)malloc(sizeof(float) * N);
-  float *cpu_ref = (float *)malloc(sizeof(float) * N);
-  float *gpu_ref = (float *)malloc(sizeof(float) * N);
-  float *dut = (float *)malloc(sizeof(float) * N);
-
-  for (int i = 0; i < N; i++) {
-    float in = ((float)rand() / RAND_MAX) * 10.0 - 1.0;
-    vin[i] = in;
+// Each environment runs its share as one batch, so the vectors stay in its
+// buffers for the heatmap and the CSV
+static void test_random_cases(unsigned seed) {
+  tb_source srcs[MAX_ENVS];
+  error_hist *hist = error_hist_alloc();
+  for (int e = 0; e < env_count; e++) {
+    int lo = (int)((int64_t)RANDOM_N * e / env_count);
+    int hi = (int)((int64_t)RANDOM_N * (e + 1) / env_count);
+    tb_source_random(&srcs[e], seed + e, hi - lo);
   }
 
   printf("=== Random TANH Tests ===\n");
-  printf("Computing reference values...\n");
-  compute_reference(vin, cpu_ref, gpu_ref, N);
-
-  printf("Driving DUT...\n");
-  drive_dut(vin, dut, N);
-
-  compute_error_stats(vin, dut, cpu_ref, N, 1e-4, 2, true, "CPU_Ref");
-#ifdef __USE_GPU_REF__
-  compute_error_stats(vin, dut, gpu_ref, N, 1e-4, 2, true, "GPU_Ref");
-#endif
-
-  save_data_to_csv("build/random_cases.csv", vin, dut, cpu_ref, gpu_ref, N);
+  printf("Driving DUT and checking against the references");
+  if (env_count > 1)
+    printf(" in %d environments", env_count);
+  printf("...\n");
+  if (print_failures)
+    print_failure_header();
+  tb_env_run_parallel(envs, srcs, env_count, NULL, NULL);
+  tb_env_print_stats(envs, env_count);
+
+  phase_begin();
+  for (int e = 0; e < env_count; e++)
+    error_hist_update(hist, envs[e].vin, envs[e].dut, envs[e].sb.refs.out[0],
+                      (int)srcs[e].end);
+  phase_end(TB_PHASE_STATS);
+
+  phase_begin();
+  for (int e = 0; e < env_count; e++) {
+    if (e == 0)
+      ref_set_save_csv(&envs[e].sb.refs, "build/random_cases.csv",
+                       envs[e].vin, envs[e].dut, (int)srcs[e].end);
+    else
+      ref_set_append_csv(&envs[e].sb.refs, "build/random_cases.csv",
+                         envs[e].vin, envs[e].dut, (int)srcs[e].end);
+  }
+  error_hist_save(hist, heatmap_prefix);
+  phase_end(TB_PHASE_OUTPUT);
 
-  free(vin);
-  free(cpu_ref);
-  free(gpu_ref);
-  free(dut);
+  error_hist_free(hist);
 }
 
 static void test_special_cases() {
@@ -270,36 +251,613 @@ static void test_special_cases() {
       (float)-M_PI,  (float)M_E,     (float)-M_E, (float)M_LN2, (float)-M_LN2,
       (float)M_LN10, (float)-M_LN10, 88.0f,       89.0f,        90.0f,
       -87.0f,        -88.0f,         -89.0f};
-  float cpu_ref[N];
-  float gpu_ref[N];
   float dut[N];
+  uint8_t stall[N];
+  // Its own scoreboard, so these do not count toward the main run
+  tb_scoreboard sb;
+  tb_scoreboard_init(&sb, ref_list, ref_count, N, ref_threads, true,
+                     envs[0].model);
 
   printf("\n=== Special TANH Tests ===\n");
-  printf("Computing reference values...\n");
-  compute_reference(vin, cpu_ref, gpu_ref, N);
-
   printf("Driving DUT...\n");
-  drive_dut(vin, dut, N);
+  phase_begin();
+  tb_env_drive(&envs[0], vin, dut, stall, N);
+  phase_end(TB_PHASE_DRIVE);
 
-  compute_error_stats(vin, dut, cpu_ref, N, 1e-4, 2, true, "CPU_Ref");
-#ifdef __USE_GPU_REF__
-  compute_error_stats(vin, dut, gpu_ref, N, 1e-4, 2, true, "GPU_Ref");
-#endif
+  if (coverage) {
+    for (int i = 0; i < N; i++)
+      cov_sample(&coverage_total, float_bits(vin[i]), stall[i]);
+  }
+
+  print_failure_header();
+  phase_begin();
+  tb_scoreboard_check(&sb, vin, dut, N);
+  phase_end(TB_PHASE_REFERENCE);
+  ref_set_print(&sb.refs);
+  const ref_set *sets[1] = {&sb.refs};
+  check_ref_stats(sets, 1, false);
+  tb_scoreboard_free(&sb);
 }
 
-int main() {
-  printf("Initializing TANH simulation...\n");
-  printf("References: CPU tanhf");
-#ifdef __USE_GPU_REF__
-  printf(" + NVIDIA GPU SFU");
+// Per-environment state of the coverage and sequential campaigns. Every
+// environment runs one batch per round; between rounds the main thread
+// merges its hits or intervals into the campaign's, which the next round's
+// hole picking and the stopping rule read.
+struct campaign_state {
+  cov_db cov;
+  seq_state *seq;
+  error_hist *hist;
+};
+
+// Runs one round and returns the number of vectors it drove
+static uint64_t campaign_round(tb_source *srcs, tb_batch_fn done,
+                               campaign_state *state) {
+  uint64_t before = 0, after = 0;
+  for (int e = 0; e < env_count; e++)
+    before += srcs[e].next;
+  tb_env_run_parallel(envs, srcs, env_count, done, state);
+  for (int e = 0; e < env_count; e++)
+    after += srcs[e].next;
+  return after - before;
+}
+
+// Splits max_n between the environments
+static uint64_t campaign_share(int max_n, int e) {
+  int64_t lo = (int64_t)max_n * e / env_count;
+  int64_t hi = (int64_t)max_n * (e + 1) / env_count;
+  return (uint64_t)(hi - lo);
+}
+
+// One hole picks the batch's backpressure, every vector aims at a hole
+static int fill_coverage(tb_source *src, float *vin, int n) {
+  // Backpressure that favours each (issue, drain) stall combination
+  static const double stall_backpressure[4] = {0.0, 0.5, 0.5, 0.8};
+  tb_env *env = (tb_env *)src->user;
+  uint64_t left = src->end - src->next;
+  if (cov_closed(&coverage_total) || left == 0)
+    return 0;
+  if (left < (uint64_t)n)
+    n = (int)left;
+
+  cov_target target;
+  cov_pick_hole(&coverage_total, &target, &src->rng);
+  env->driver.backpressure = stall_backpressure[target.stall];
+  for (int i = 0; i < n; i++) {
+    cov_pick_hole(&coverage_total, &target, &src->rng);
+    vin[i] = bits_float(cov_make_input(&target, &src->rng));
+  }
+  src->next += n;
+  return n;
+}
+
+static bool coverage_batch(tb_env *env, int n, void *arg) {
+  campaign_state *s = &((campaign_state *)arg)[env->id];
+  for (int i = 0; i < n; i++)
+    cov_sample(&s->cov, float_bits(env->vin[i]), env->stall[i]);
+  error_hist_update(s->hist, env->vin, env->dut, env->sb.refs.out[0], n);
+  return false;
+}
+
+static void test_coverage_closure(int max_n, const char *report_file,
+                                  unsigned seed) {
+  tb_source srcs[MAX_ENVS];
+  campaign_state state[MAX_ENVS];
+  double saved_backpressure[MAX_ENVS];
+  for (int e = 0; e < env_count; e++) {
+    memset(&srcs[e], 0, sizeof(srcs[e]));
+    srcs[e].fill = fill_coverage;
+    srcs[e].end = campaign_share(max_n, e);
+    srcs[e].rng = seed + e;
+    srcs[e].user = &envs[e];
+    memset(&state[e], 0, sizeof(state[e]));
+    state[e].hist = error_hist_alloc();
+    saved_backpressure[e] = envs[e].driver.backpressure;
+  }
+
+  printf("\n=== Coverage-Driven TANH Tests ===\n");
+  printf("Generating toward empty bins until %d bins close or %d vectors",
+         cov_bins(), max_n);
+  if (env_count > 1)
+    printf(" in %d environments", env_count);
+  printf("...\n");
+  if (print_failures) {
+    print_failure_header();
+  }
+
+  uint64_t total = 0;
+  for (;;) {
+    uint64_t n = campaign_round(srcs, coverage_batch, state);
+    for (int e = 0; e < env_count; e++) {
+      cov_merge(&coverage_total, &state[e].cov);
+      cov_init(&state[e].cov);
+    }
+    if (n == 0)
+      break;
+    total += n;
+  }
+  for (int e = 0; e < env_count; e++) {
+    envs[e].driver.backpressure = saved_backpressure[e];
+    if (e > 0)
+      error_hist_merge(state[0].hist, state[e].hist);
+  }
+
+  tb_env_print_stats(envs, env_count);
+  cov_report(&coverage_total, report_file);
+  printf("%s after %lu vectors\n",
+         cov_closed(&coverage_total) ? "Coverage closed" : "Budget exhausted",
+         total);
+  error_hist_save(state[0].hist, heatmap_prefix);
+  for (int e = 0; e < env_count; e++)
+    error_hist_free(state[e].hist);
+}
+
+static bool sequential_batch(tb_env *env, int n, void *arg) {
+  campaign_state *s = &((campaign_state *)arg)[env->id];
+  error_hist_update(s->hist, env->vin, env->dut, env->sb.refs.out[0], n);
+  seq_update(s->seq, env->vin, env->dut, env->sb.refs.out[0], n,
+             env->sb.err_threshold, env->sb.ulp_threshold);
+  return false;
+}
+
+// The random run in batches, stopping as soon as the per-segment confidence
+// intervals are narrow enough instead of after a fixed RANDOM_N vectors
+static void test_sequential_cases(int max_n, const seq_config *cfg,
+                                  const char *report_file, unsigned seed) {
+  tb_source srcs[MAX_ENVS];
+  campaign_state state[MAX_ENVS];
+  seq_state *total = seq_alloc(cfg);
+  for (int e = 0; e < env_count; e++) {
+    tb_source_random(&srcs[e], seed + e, campaign_share(max_n, e));
+    memset(&state[e], 0, sizeof(state[e]));
+    state[e].hist = error_hist_alloc();
+    state[e].seq = seq_alloc(cfg);
+  }
+
+  printf("\n=== Sequential Random TANH Tests ===\n");
+  printf("Generating batches of %d until the intervals converge or %d "
+         "vectors",
+         envs[0].batch, max_n);
+  if (env_count > 1)
+    printf(" in %d environments", env_count);
+  printf("...\n");
+  if (print_failures) {
+    print_failure_header();
+  }
+
+  for (;;) {
+    uint64_t n = campaign_round(srcs, sequential_batch, state);
+    for (int e = 0; e < env_count; e++)
+      seq_merge(total, state[e].seq);
+    if (n == 0 || seq_converged(total))
+      break;
+  }
+  for (int e = 1; e < env_count; e++)
+    error_hist_merge(state[0].hist, state[e].hist);
+
+  tb_env_print_stats(envs, env_count);
+  seq_report(total, RANDOM_N, report_file);
+  phase_begin();
+  error_hist_save(state[0].hist, heatmap_prefix);
+  phase_end(TB_PHASE_OUTPUT);
+
+  for (int e = 0; e < env_count; e++) {
+    error_hist_free(state[e].hist);
+    seq_free(state[e].seq);
+  }
+  seq_free(total);
+}
+
+// Per-environment state of the exhaustive sweep
+struct sweep_state {
+  error_hist *hist;
+  float *model; // NULL without coefficients
+  uint64_t mismatch;
+  uint64_t done, size;
+  uint64_t batches;
+};
+
+static bool exhaustive_batch(tb_env *env, int n, void *arg) {
+  sweep_state *s = &((sweep_state *)arg)[env->id];
+  error_hist_update(s->hist, env->vin, env->dut, env->sb.refs.out[0], n);
+  if (s->model) {
+    tanh_model_batch(env->model, env->vin, s->model, n);
+    for (int i = 0; i < n; i++) {
+      if (float_bits(env->dut[i]) == float_bits(s->model[i]))
+        continue;
+      if (s->mismatch++ < 10)
+        printf("Model mismatch: in 0x%08x dut 0x%08x model 0x%08x\n",
+               float_bits(env->vin[i]), float_bits(env->dut[i]),
+               float_bits(s->model[i]));
+    }
+  }
+  s->done += n;
+  // The first environment's progress stands for all of them
+  if (env->id == 0 && (++s->batches % 256 == 0 || s->done == s->size))
+    printf("  %5.1f%% done, max ULP %lu\n", 100.0 * s->done / s->size,
+           env->sb.refs.stats[0].max_ulp);
+  return true;
+}
+
+// Every bit pattern in [lo, hi), in chunks so memory stays constant. The DUT
+// is also checked bit-exact against the model; nothing per-vector is saved.
+static void test_exhaustive_cases(uint64_t lo, uint64_t hi) {
+  tb_source srcs[MAX_ENVS];
+  sweep_state state[MAX_ENVS];
+  bool check_model = model_loaded;
+
+  printf("\n=== Exhaustive TANH Tests ===\n");
+  printf("Sweeping 0x%08lx..0x%08lx (%lu inputs)", lo, hi - 1, hi - lo);
+  if (env_count > 1)
+    printf(" in %d environments", env_count);
+  printf("\n");
+  // A sweep without the model check proves nothing about the RTL
+  if (!check_model) {
+    printf("Error: The model did not load, the comparison cannot run.\n");
+    run_failed = true;
+  }
+
+  for (int e = 0; e < env_count; e++) {
+    uint64_t elo = lo + (hi - lo) * e / env_count;
+    uint64_t ehi = lo + (hi - lo) * (e + 1) / env_count;
+    tb_source_range(&srcs[e], elo, ehi);
+    envs[e].sb.print_failures = false;
+    memset(&state[e], 0, sizeof(state[e]));
+    state[e].hist = error_hist_alloc();
+    if (check_model)
+      state[e].model = (float *)malloc(sizeof(float) * envs[e].batch);
+    state[e].size = ehi - elo;
+  }
+
+  tb_env_run_parallel(envs, srcs, env_count, exhaustive_batch, state);
+
+  uint64_t model_mismatch = 0;
+  for (int e = 0; e < env_count; e++) {
+    if (e > 0)
+      error_hist_merge(state[0].hist, state[e].hist);
+    model_mismatch += state[e].mismatch;
+  }
+  tb_env_print_stats(envs, env_count);
+  if (check_model)
+    printf("Model mismatches: %lu\n", model_mismatch);
+  if (model_mismatch)
+    run_failed = true;
+  phase_begin();
+  error_hist_save(state[0].hist, heatmap_prefix);
+  phase_end(TB_PHASE_OUTPUT);
+
+  for (int e = 0; e < env_count; e++) {
+    error_hist_free(state[e].hist);
+    free(state[e].model);
+  }
+}
+
+static void usage(const char *prog) {
+  printf("Usage: %s [options]\n", prog);
+  printf("  --bench FILE        Write phase timings and throughput to FILE "
+         "(JSON)\n");
+  printf("  --build-time SEC    Build time to record in the benchmark file\n");
+  printf("  --seed N            Random seed (default: time)\n");
+  printf("  --backpressure P    Hold io_out_ready low with probability P\n");
+  printf("  --pipe-report FILE  Save the pipeline occupancy report to FILE\n");
+  printf("  --pipe-trace FILE   Write a per-cycle pipeline trace to FILE\n");
+  printf("  --pipe-trace-cycles N\n");
+  printf("                      Cycles to trace (default: 10000)\n");
+  printf("  --reg-report FILE   Save the pipeline register bit report to "
+         "FILE\n");
+  printf("  --coverage          Replace the fixed random run with "
+         "coverage-driven\n");
+  printf("                      generation that stops at closure\n");
+  printf("  --cov-max N         Vector budget for --coverage (default: "
+         "1000000)\n");
+  printf("  --cov-report FILE   Save the per-bin coverage report to FILE\n");
+  printf("  --seq               Replace the fixed random run with batches "
+         "that stop\n");
+  printf("                      once the per-segment intervals converge\n");
+  printf("  --seq-max N         Vector budget for --seq (default: 1000000)\n");
+  printf("  --seq-conf C        Two-sided confidence level (default: 0.95)\n");
+  printf("  --seq-tol T         Max pass-rate half-width (default: 0.02)\n");
+  printf("  --seq-quantile Q    ULP quantile to bound (default: 0.99)\n");
+  printf("  --seq-ulp-tol N     Max ULP quantile interval width (default: "
+         "2)\n");
+  printf("  --seq-report FILE   Save the per-segment report to FILE\n");
+  printf("  --heatmap PREFIX    Error heatmap output prefix (default: "
+         "build/heatmap)\n");
+  printf("  --exhaustive        Sweep every input bit pattern instead of the "
+         "random run\n");
+  printf("  --range LO:HI       Bit-pattern range for --exhaustive, HI "
+         "exclusive\n");
+  printf("                      (default: 0:0x100000000)\n");
+  printf("  --lut FILE          Coefficients for the model check (default: "
+         "lut.txt)\n");
+  printf("  --fixup FILE        Fix-up table of the RTL for the model check\n");
+  printf("  --mul-trunc N       Product columns the RTL multiplier drops "
+         "(default: 0)\n");
+  printf("  --add-width N       Product bits into the RTL FMA adder "
+         "(default: 48)\n");
+  printf("  --fwd-width N       Accumulator bits the RTL forwards between "
+         "CMAs (default: 24)\n");
+  printf("  --ref LIST          Comma-separated references to check against; "
+         "the first\n");
+  printf("                      is primary (default: %s; available: ",
+         ref_default_names);
+  ref_list_providers();
+  printf(")\n");
+  printf("  --ref-threads N     Threads of the reference pass (default: all "
+         "cores)\n");
+  printf("  --max-ulp N         Fail the run if the primary reference's max "
+         "ULP exceeds N\n");
+  printf("  --envs N            Independent DUT environments running the random "
+         "run,\n");
+  printf("                      the campaigns or the sweep in parallel "
+         "(default: 1)\n");
+}
+
+int main(int argc, char **argv) {
+  const char *bench_file = NULL;
+  double build_time = -1.0;
+  unsigned seed = time(NULL);
+  const char *pipe_report = NULL;
+  const char *reg_report = NULL;
+  const char *pipe_trace = NULL;
+#ifdef CONFIG_PIPE_PROFILE
+  uint64_t pipe_trace_cycles = 10000;
+#endif
+  int cov_max = 1000000;
+  const char *cov_report_file = NULL;
+  bool sequential = false;
+  int seq_max = RANDOM_N;
+  seq_config seq_cfg = {0.95, 0.02, 0.99, 2};
+  const char *seq_report_file = NULL;
+  bool exhaustive = false;
+  uint64_t range_lo = 0, range_hi = 1ull << 32;
+  const char *lut_file = "lut.txt";
+  const char *fixup_file = NULL;
+  int mul_trunc = 0, add_width = TANH_MODEL_FULL_ADD_WIDTH;
+  int fwd_width = TANH_MODEL_MIN_FWD_WIDTH;
+  const char *ref_names = ref_default_names;
+  char *end;
+
+  static struct option long_opts[] = {
+      {"bench", required_argument, NULL, 'b'},
+      {"build-time", required_argument, NULL, 't'},
+      {"seed", required_argument, NULL, 's'},
+      {"backpressure", required_argument, NULL, 'p'},
+      {"pipe-report", required_argument, NULL, 'r'},
+      {"reg-report", required_argument, NULL, 'P'},
+      {"pipe-trace", required_argument, NULL, 'T'},
+      {"pipe-trace-cycles", required_argument, NULL, 'C'},
+      {"coverage", no_argument, NULL, 'c'},
+      {"cov-max", required_argument, NULL, 'M'},
+      {"cov-report", required_argument, NULL, 'R'},
+      {"seq", no_argument, NULL, 'q'},
+      {"seq-max", required_argument, NULL, 'm'},
+      {"seq-conf", required_argument, NULL, 'k'},
+      {"seq-tol", required_argument, NULL, 'o'},
+      {"seq-quantile", required_argument, NULL, 'Q'},
+      {"seq-ulp-tol", required_argument, NULL, 'u'},
+      {"seq-report", required_argument, NULL, 'S'},
+      {"heatmap", required_argument, NULL, 'H'},
+      {"exhaustive", no_argument, NULL, 'x'},
+      {"range", required_argument, NULL, 'g'},
+      {"lut", required_argument, NULL, 'l'},
+      {"fixup", required_argument, NULL, 'F'},
+      {"mul-trunc", required_argument, NULL, 'U'},
+      {"add-width", required_argument, NULL, 'W'},
+      {"fwd-width", required_argument, NULL, 'f'},
+      {"ref", required_argument, NULL, 'e'},
+      {"ref-threads", required_argument, NULL, 'j'},
+      {"envs", required_argument, NULL, 'E'},
+      {"max-ulp", required_argument, NULL, 'L'},
+      {"help", no_argument, NULL, 'h'},
+      {NULL, 0, NULL, 0}};
+  int opt;
+  while ((opt = getopt_long(argc, argv, "h", long_opts, NULL)) != -1) {
+    switch (opt) {
+    case 'b':
+      bench_file = optarg;
+      break;
+    case 't':
+      build_time = atof(optarg);
+      break;
+    case 's':
+      seed = strtoul(optarg, NULL, 0);
+      break;
+    case 'p':
+      backpressure = atof(optarg);
+      break;
+    case 'r':
+      pipe_report = optarg;
+      break;
+    case 'P':
+      reg_report = optarg;
+      break;
+    case 'T':
+      pipe_trace = optarg;
+      break;
+    case 'C':
+#ifdef CONFIG_PIPE_PROFILE
+      pipe_trace_cycles = strtoull(optarg, NULL, 0);
+#endif
+      break;
+    case 'c':
+      coverage = true;
+      break;
+    case 'M':
+      cov_max = atoi(optarg);
+      break;
+    case 'R':
+      cov_report_file = optarg;
+      break;
+    case 'q':
+      sequential = true;
+      break;
+    case 'm':
+      seq_max = atoi(optarg);
+      break;
+    case 'k':
+      seq_cfg.confidence = atof(optarg);
+      break;
+    case 'o':
+      seq_cfg.pass_tol = atof(optarg);
+      break;
+    case 'Q':
+      seq_cfg.quantile = atof(optarg);
+      break;
+    case 'u':
+      seq_cfg.ulp_tol = strtoull(optarg, NULL, 0);
+      break;
+    case 'S':
+      seq_report_file = optarg;
+      break;
+    case 'H':
+      heatmap_prefix = optarg;
+      break;
+    case 'x':
+      exhaustive = true;
+      break;
+    case 'g':
+      range_lo = strtoull(optarg, &end, 0);
+      range_hi = *end == ':' ? strtoull(end + 1, NULL, 0) : range_lo + 1;
+      if (range_hi > 1ull << 32 || range_lo >= range_hi) {
+        printf("Error: Invalid range '%s'\n", optarg);
+        return 1;
+      }
+      break;
+    case 'l':
+      lut_file = optarg;
+      break;
+    case 'F':
+      fixup_file = optarg;
+      break;
+    case 'U':
+      mul_trunc = atoi(optarg);
+      break;
+    case 'W':
+      add_width = atoi(optarg);
+      break;
+    case 'f':
+      fwd_width = atoi(optarg);
+      break;
+    case 'e':
+      ref_names = optarg;
+      break;
+    case 'j':
+      ref_threads = atoi(optarg);
+      break;
+    case 'E':
+      env_count = atoi(optarg);
+      break;
+    case 'L':
+      max_ulp = strtoll(optarg, NULL, 0);
+      break;
+    default:
+      usage(argv[0]);
+      return opt == 'h' ? 0 : 1;
+    }
+  }
+  // Printing half a million failures would dominate the stats phase
+  if (bench_file)
+    print_failures = false;
+#ifndef CONFIG_PIPE_PROFILE
+  if (pipe_report || pipe_trace)
+    printf("Warning: Pipeline profiling needs a CONFIG_PIPE_PROFILE build "
+           "(make pipeprof).\n");
+#endif
+#ifndef CONFIG_REG_PROFILE
+  if (reg_report)
+    printf("Warning: Register profiling needs a CONFIG_REG_PROFILE build "
+           "(make regprof).\n");
 #endif
+  if (seq_cfg.confidence <= 0.0 || seq_cfg.confidence >= 1.0 ||
+      seq_cfg.quantile <= 0.0 || seq_cfg.quantile >= 1.0) {
+    printf("Error: --seq-conf and --seq-quantile must lie in (0, 1)\n");
+    return 1;
+  }
+  if (env_count < 1 || env_count > MAX_ENVS) {
+    printf("Error: --envs must be in 1..%d\n", MAX_ENVS);
+    return 1;
+  }
+#ifdef CONFIG_WAVE_TRACE
+  if (exhaustive) {
+    printf("Error: --exhaustive needs a build without wave tracing "
+           "(make sweep).\n");
+    return 1;
+  }
+#endif
+
+  ref_count = ref_parse(ref_names, ref_list);
+  if (ref_count < 0)
+    return 1;
+  // The sweep checks against the model whenever coefficients load
+  bool need_model = exhaustive;
+  for (int r = 0; r < ref_count; r++)
+    need_model |= ref_list[r]->model_batch != NULL;
+  if (need_model) {
+    tanh_model_init(&model);
+    // A datapath the model cannot match is an error, not a skipped check
+    if (!tanh_model_configure_datapath(&model, mul_trunc, add_width,
+                                       fwd_width))
+      return 1;
+    model_loaded = tanh_model_load_lut(&model, lut_file) &&
+                   tanh_model_load_fixup(&model, fixup_file);
+  }
+  for (int r = 0; r < ref_count; r++) {
+    if (ref_list[r]->model_batch && !model_loaded)
+      return 1;
+  }
+
+  printf("Initializing TANH simulation...\n");
+  printf("References:");
+  for (int r = 0; r < ref_count; r++)
+    printf(" %s", ref_list[r]->label);
   printf("\n\n");
-  sim_init();
-  srand(time(NULL));
+  int batch = exhaustive               ? 1 << 20
+              : coverage || sequential ? 4096
+                                       : (RANDOM_N + env_count - 1) / env_count;
+  envs_init(batch, seed);
+  // The profilers follow the first environment
+#ifdef CONFIG_PIPE_PROFILE
+  if (!pipeprof_init(envs[0].sim.contextp, pipe_trace, pipe_trace_cycles))
+    run_failed = true;
+#endif
+#ifdef CONFIG_REG_PROFILE
+  regprof_init(envs[0].sim.contextp);
+#endif
+#if defined(CONFIG_PIPE_PROFILE) || defined(CONFIG_REG_PROFILE)
+  envs[0].on_cycle = profile_cycle;
+#endif
+  if (backpressure > 0.0)
+    printf("Backpressure: io_out_ready low %.0f%% of cycles\n",
+           backpressure * 100.0);
+  printf("Seed: %u\n", seed);
+  if (coverage)
+    cov_init(&coverage_total);
   test_special_cases();
-  test_random_cases();
-  printf("Total cycles: %lu\n", cycle_count);
+  if (exhaustive)
+    test_exhaustive_cases(range_lo, range_hi);
+  else if (coverage)
+    test_coverage_closure(cov_max, cov_report_file, seed);
+  else if (sequential)
+    test_sequential_cases(seq_max, &seq_cfg, seq_report_file, seed);
+  else
+    test_random_cases(seed);
+  check_env_stats();
+  collect_env_phases();
+  printf("Total cycles: %lu\n", total_cycles);
+  printf("Simulation speed: %.0f cycles/s\n",
+         drive_cycles / phase_time[TB_PHASE_DRIVE]);
+  if (bench_file)
+    save_bench_json(bench_file, build_time, seed);
+#ifdef CONFIG_PIPE_PROFILE
+  pipeprof_report(pipe_report);
+  pipeprof_exit();
+#endif
+#ifdef CONFIG_REG_PROFILE
+  regprof_report(reg_report);
+  regprof_exit();
+#endif
   printf("\nSimulation complete.\n");
-  sim_exit();
-  return 0;
+  printf("%s\n", run_failed ? "FAILED" : "PASSED");
+  envs_free();
+  return run_failed ? 1 : 0;
 }
@@ -0,0 +1,268 @@
+// Multi-clock testbench for TANHFP32CDC: the core and the fabric run on
+// independent clocks, stepped edge by edge in a common timebase. Every
+// result is checked bit-exactly against the model, and the fabric-side
+// throughput must reach what the slower of the two sides allows.
+
+#include "TANHFP32_harness.h"
+#include "TANHFP32_model.h"
+#include <VTANHFP32CDC.h>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <getopt.h>
+
+#ifndef CONFIG_CDC_LANES
+#define CONFIG_CDC_LANES 2
+#endif
+#define LANES CONFIG_CDC_LANES
+
+#if LANES != 1 && LANES != 2 && LANES != 4
+#error "CONFIG_CDC_LANES must be 1, 2 or 4"
+#endif
+
+// Steady-state throughput may fall short of the bound by this fraction
+// (random backpressure and the fill and drain at the ends of the run)
+#define RATE_TOL 0.05
+
+static tb_sim<VTANHFP32CDC> sim;
+static VTANHFP32CDC *top = NULL;
+static uint32_t *in_port[LANES];
+static uint8_t *rm_port[LANES];
+static uint32_t *out_port[LANES];
+
+// Timebase in arbitrary units; a clock toggles every half period
+static uint64_t core_period = 10;
+static uint64_t fabric_period = 20;
+static uint64_t sim_time = 0;
+static uint64_t next_core_edge = 0;
+static uint64_t next_fabric_edge = 0;
+static uint64_t core_cycles = 0;
+static uint64_t fabric_cycles = 0;
+static tanh_model model;
+
+static void bind_ports() {
+  in_port[0] = &top->io_in_bits_0_in;
+  rm_port[0] = &top->io_in_bits_0_rm;
+  out_port[0] = &top->io_out_bits_0;
+#if LANES > 1
+  in_port[1] = &top->io_in_bits_1_in;
+  rm_port[1] = &top->io_in_bits_1_rm;
+  out_port[1] = &top->io_out_bits_1;
+#endif
+#if LANES > 2
+  in_port[2] = &top->io_in_bits_2_in;
+  rm_port[2] = &top->io_in_bits_2_rm;
+  out_port[2] = &top->io_out_bits_2;
+  in_port[3] = &top->io_in_bits_3_in;
+  rm_port[3] = &top->io_in_bits_3_rm;
+  out_port[3] = &top->io_out_bits_3;
+#endif
+}
+
+// Advances to the next clock edge (either clock, or both when they
+// coincide) and returns true if it was a rising fabric edge
+static bool step_edge(void (*before_fabric_rise)(), void (*after_fabric_rise)()) {
+  sim_time = next_core_edge < next_fabric_edge ? next_core_edge : next_fabric_edge;
+  bool core_edge = sim_time == next_core_edge;
+  bool fabric_edge = sim_time == next_fabric_edge;
+  bool fabric_rise = fabric_edge && !top->fabricClock;
+
+  top->eval();
+  if (fabric_rise && before_fabric_rise)
+    before_fabric_rise();
+  if (core_edge) {
+    top->coreClock = !top->coreClock;
+    core_cycles += top->coreClock;
+    next_core_edge += core_period / 2;
+  }
+  if (fabric_edge) {
+    top->fabricClock = !top->fabricClock;
+    fabric_cycles += top->fabricClock;
+    next_fabric_edge += fabric_period / 2;
+  }
+  top->eval();
+  if (fabric_rise && after_fabric_rise)
+    after_fabric_rise();
+  return fabric_rise;
+}
+
+static void sim_init() {
+  tb_sim_init(&sim, NULL);
+  top = sim.top;
+  bind_ports();
+  top->coreReset = 1;
+  top->fabricReset = 1;
+  next_core_edge = core_period / 2;
+  next_fabric_edge = fabric_period / 2;
+  // Hold both resets for 10 cycles of the slower clock
+  while (core_cycles < 10 || fabric_cycles < 10)
+    step_edge(NULL, NULL);
+  top->coreReset = 0;
+  top->fabricReset = 0;
+  core_cycles = 0;
+  fabric_cycles = 0;
+}
+
+// Fabric-side driver state
+static uint32_t *vin;
+static uint32_t *vout;
+static int n_words;
+static int issued, received;
+static uint64_t first_out_cycle, last_out_cycle;
+static double backpressure = 0.0;
+static unsigned rand_state = 1;
+static bool in_fire, out_fire;
+static uint32_t out_bits[LANES];
+
+static void sample_fabric() {
+  in_fire = top->io_in_valid && top->io_in_ready;
+  out_fire = top->io_out_valid && top->io_out_ready;
+  for (int l = 0; l < LANES; l++)
+    out_bits[l] = *out_port[l];
+}
+
+static void drive_fabric() {
+  if (in_fire)
+    issued++;
+  if (out_fire) {
+    if (received == 0)
+      first_out_cycle = fabric_cycles;
+    last_out_cycle = fabric_cycles;
+    memcpy(&vout[received * LANES], out_bits, sizeof(out_bits));
+    received++;
+  }
+  top->io_in_valid = issued < n_words;
+  if (issued < n_words) {
+    for (int l = 0; l < LANES; l++) {
+      *in_port[l] = vin[issued * LANES + l];
+      *rm_port[l] = 0;
+    }
+  }
+  top->io_out_ready =
+      backpressure <= 0.0 || rand_r(&rand_state) >= backpressure * RAND_MAX;
+}
+
+static void usage(const char *prog) {
+  printf("Usage: %s [options]\n", prog);
+  printf("  --n N               Fabric words to send, %d lanes each "
+         "(default: 100000)\n", LANES);
+  printf("  --core-period T     Core clock period, even (default: 10)\n");
+  printf("  --fabric-period T   Fabric clock period, even (default: 20)\n");
+  printf("  --backpressure P    Probability of holding io_out_ready low "
+         "(default: 0)\n");
+  printf("  --seed S            Random seed (default: 1)\n");
+  printf("  --lut FILE          Coefficient file of the RTL (default: "
+         "lut.txt)\n");
+}
+
+int main(int argc, char **argv) {
+  const char *lut_file = "lut.txt";
+  unsigned seed = 1;
+  n_words = 100000;
+
+  static struct option long_opts[] = {
+      {"n", required_argument, NULL, 'n'},
+      {"core-period", required_argument, NULL, 'c'},
+      {"fabric-period", required_argument, NULL, 'f'},
+      {"backpressure", required_argument, NULL, 'b'},
+      {"seed", required_argument, NULL, 's'},
+      {"lut", required_argument, NULL, 'l'},
+      {"help", no_argument, NULL, 'h'},
+      {NULL, 0, NULL, 0}};
+  int opt;
+  while ((opt = getopt_long(argc, argv, "h", long_opts, NULL)) != -1) {
+    switch (opt) {
+    case 'n':
+      n_words = atoi(optarg);
+      break;
+    case 'c':
+      core_period = strtoull(optarg, NULL, 0);
+      break;
+    case 'f':
+      fabric_period = strtoull(optarg, NULL, 0);
+      break;
+    case 'b':
+      backpressure = atof(optarg);
+      break;
+    case 's':
+      seed = strtoul(optarg, NULL, 0);
+      break;
+    case 'l':
+      lut_file = optarg;
+      break;
+    default:
+      usage(argv[0]);
+      return opt == 'h' ? 0 : 1;
+    }
+  }
+  if (n_words <= 0 || core_period < 2 || fabric_period < 2 ||
+      core_period % 2 || fabric_period % 2) {
+    printf("Error: Need N > 0 and even clock periods >= 2\n");
+    return 1;
+  }
+  tanh_model_init(&model);
+  if (!tanh_model_load_lut(&model, lut_file))
+    return 1;
+
+  vin = (uint32_t *)malloc(sizeof(uint32_t) * n_words * LANES);
+  vout = (uint32_t *)malloc(sizeof(uint32_t) * n_words * LANES);
+  unsigned state = seed;
+  rand_state = seed;
+  for (int i = 0; i < n_words * LANES; i++)
+    vin[i] = tb_mixed_input(&state);
+
+  printf("\n=== TANHFP32CDC Multi-Clock Test ===\n");
+  printf("Lanes %d, core period %lu, fabric period %lu (core/fabric clock "
+         "%.2fx), backpressure %.2f\n",
+         LANES, core_period, fabric_period,
+         (double)fabric_period / core_period, backpressure);
+
+  sim_init();
+  tb_watchdog watchdog;
+  tb_watchdog_init(&watchdog, 10000);
+  while (received < n_words) {
+    if (!step_edge(sample_fabric, drive_fabric))
+      continue;
+    if (tb_watchdog_expired(&watchdog, received)) {
+      printf("Error: No output for %lu fabric cycles, %d of %d words "
+             "received\n", watchdog.idle, received, n_words);
+      break;
+    }
+  }
+
+  uint64_t mismatch = 0;
+  for (int i = 0; i < received * LANES; i++) {
+    uint32_t expect = tanh_model_eval(&model, vin[i]);
+    if (vout[i] != expect && mismatch++ < 10)
+      printf("Mismatch: word %d lane %d in 0x%08x dut 0x%08x model 0x%08x\n",
+             i / LANES, i % LANES, vin[i], vout[i], expect);
+  }
+
+  // Steady state: from the first to the last result word
+  double span = last_out_cycle - first_out_cycle + 1;
+  double achieved = received > 1 ? (received - 1) * LANES / (span - 1) : 0.0;
+  // min(f_core, LANES * f_fabric) in results per fabric cycle; backpressure
+  // only throttles the fabric side
+  double core_limit = (double)fabric_period / core_period;
+  double fabric_limit = LANES * (1.0 - backpressure);
+  double ideal = core_limit < fabric_limit ? core_limit : fabric_limit;
+
+  printf("\nWords received:       %d of %d\n", received, n_words);
+  printf("Model mismatches:     %lu\n", mismatch);
+  printf("Fabric cycles:        %lu\n", fabric_cycles);
+  printf("Core cycles:          %lu\n", core_cycles);
+  printf("Throughput:           %.3f results/fabric cycle\n", achieved);
+  printf("Bound:                %.3f results/fabric cycle (%s)\n", ideal,
+         core_limit < fabric_limit ? "core clock" : "fabric lanes");
+  printf("Efficiency:           %.1f%% (min %.0f%%)\n",
+         100.0 * achieved / ideal, 100.0 * (1.0 - RATE_TOL));
+
+  bool pass = received == n_words && mismatch == 0 &&
+              achieved >= ideal * (1.0 - RATE_TOL);
+  printf("\n%s\n", pass ? "PASSED" : "FAILED");
+  free(vin);
+  free(vout);
+  tb_sim_free(&sim);
+  return pass ? 0 : 1;
+}
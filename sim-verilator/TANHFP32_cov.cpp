@@ -0,0 +1,143 @@
+#include "TANHFP32_cov.h"
+#include "TANHFP32_model.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+static inline int bin_index(int cls, int sign, int stall) {
+  return (cls * 2 + sign) * 4 + stall;
+}
+
+void cov_init(cov_db *db) { memset(db, 0, sizeof(*db)); }
+
+void cov_sample(cov_db *db, uint32_t x, int stall) {
+  int bin = bin_index(tanh_input_class(x), x >> 31, stall & 3);
+  if (db->hits[bin]++ == 0)
+    db->covered++;
+}
+
+void cov_merge(cov_db *dst, const cov_db *src) {
+  for (int bin = 0; bin < COV_BINS; bin++) {
+    if (src->hits[bin] && dst->hits[bin] == 0)
+      dst->covered++;
+    dst->hits[bin] += src->hits[bin];
+  }
+}
+
+int cov_bins() { return COV_BINS; }
+
+int cov_covered(const cov_db *db) { return db->covered; }
+
+bool cov_closed(const cov_db *db) { return db->covered == COV_BINS; }
+
+bool cov_pick_hole(const cov_db *db, cov_target *target, unsigned *rng) {
+  int holes = COV_BINS - db->covered;
+  if (holes == 0)
+    return false;
+
+  int skip = rand_r(rng) % holes;
+  for (int bin = 0; bin < COV_BINS; bin++) {
+    if (db->hits[bin] == 0 && skip-- == 0) {
+      target->bin = bin;
+      target->stall = bin & 3;
+      return true;
+    }
+  }
+  return false;
+}
+
+static uint32_t rand_bits(unsigned *rng, int bits) {
+  uint32_t r = ((uint32_t)rand_r(rng) << 16) ^ (uint32_t)rand_r(rng);
+  return bits >= 32 ? r : r & ((1u << bits) - 1);
+}
+
+uint32_t cov_make_input(const cov_target *target, unsigned *rng) {
+  int cls = target->bin / 8;
+  uint32_t sign = (uint32_t)((target->bin / 4) & 1) << 31;
+  uint32_t exp, frac;
+
+  if (cls < TANH_MODEL_REGIONS) {
+    // Biased exponent 122 is e_unbias = -5, the first polynomial octave
+    exp = 122 + (cls >> 3);
+    frac = ((uint32_t)(cls & 7) << 20) | rand_bits(rng, 20);
+  } else {
+    switch (cls - TANH_MODEL_REGIONS + 1) {
+    case TANH_BYPASS_NAN:
+      exp = 0xFF;
+      frac = rand_bits(rng, 23) | 1;
+      break;
+    case TANH_BYPASS_INF:
+      exp = 0xFF;
+      frac = 0;
+      break;
+    case TANH_BYPASS_ZERO:
+      exp = 0;
+      frac = 0;
+      break;
+    case TANH_BYPASS_SUBNORM:
+      exp = 0;
+      frac = rand_bits(rng, 23) | 1;
+      break;
+    case TANH_BYPASS_SMALL:
+      exp = 1 + rand_r(rng) % 121;
+      frac = rand_bits(rng, 23);
+      break;
+    default:
+      exp = 130 + rand_r(rng) % 125;
+      frac = rand_bits(rng, 23);
+      break;
+    }
+  }
+  return sign | (exp << 23) | frac;
+}
+
+static void print_report(const cov_db *db, FILE *fp) {
+  fprintf(fp, "\n=== Functional Coverage ===\n");
+  fprintf(fp, "Bins=%d, Covered=%d (%.2f%%)\n", COV_BINS, db->covered,
+          db->covered * 100.0 / COV_BINS);
+
+  // One row per class: hits for each sign x (issue stall, drain stall)
+  fprintf(fp, "\n%-10s %-5s %10s %10s %10s %10s\n", "Class", "Sign", "-/-",
+          "issue/-", "-/drain", "issue/drain");
+  fprintf(fp, "-----------------------------------------------------------"
+              "---\n");
+  for (int cls = 0; cls < TANH_INPUT_CLASSES; cls++) {
+    char name[16];
+    tanh_input_class_name(cls, name, sizeof(name));
+    for (int sign = 0; sign < 2; sign++) {
+      fprintf(fp, "%-10s %-5s", name, sign ? "-" : "+");
+      for (int stall = 0; stall < 4; stall++)
+        fprintf(fp, " %10u", db->hits[bin_index(cls, sign, stall)]);
+      fprintf(fp, "\n");
+    }
+  }
+}
+
+void cov_report(const cov_db *db, const char *report_file) {
+  printf("\n=== Functional Coverage ===\n");
+  printf("Bins=%d, Covered=%d (%.2f%%)\n", COV_BINS, db->covered,
+         db->covered * 100.0 / COV_BINS);
+  int shown = 0;
+  for (int bin = 0; bin < COV_BINS && shown < 16; bin++) {
+    if (db->hits[bin])
+      continue;
+    char name[16];
+    tanh_input_class_name(bin / 8, name, sizeof(name));
+    printf("  hole: %s %s issue_stall=%d drain_stall=%d\n", name,
+           (bin & 4) ? "-" : "+", (bin & COV_STALL_ISSUE) != 0,
+           (bin & COV_STALL_DRAIN) != 0);
+    shown++;
+  }
+  if (COV_BINS - db->covered > shown)
+    printf("  ... %d more holes\n", COV_BINS - db->covered - shown);
+
+  if (report_file) {
+    FILE *fp = fopen(report_file, "w");
+    if (!fp) {
+      printf("Warning: Failed to save coverage report.\n");
+      return;
+    }
+    print_report(db, fp);
+    fclose(fp);
+  }
+}
@@ -0,0 +1,51 @@
+#ifndef __TANHFP32_COV_H__
+#define __TANHFP32_COV_H__
+
+#include "TANHFP32_model.h"
+#include <cstdint>
+
+// Functional coverage model.
+//
+// One cross bin per (input class, sign, stalled during issue, stalled
+// during drain). The input class is one of the 64 LUT regions or one of
+// the filter's bypass reasons. A transaction is stalled during issue when
+// io_in_valid was held against a low io_in_ready, and during drain when its
+// result waited on a low io_out_ready.
+//
+// Hits live in a cov_db, so parallel environments can each sample into
+// their own and merge them between batches.
+
+#define COV_STALL_ISSUE 0x1
+#define COV_STALL_DRAIN 0x2
+#define COV_BINS (TANH_INPUT_CLASSES * 2 * 4)
+
+struct cov_db {
+  uint32_t hits[COV_BINS];
+  int covered;
+};
+
+struct cov_target {
+  int bin;
+  int stall;
+};
+
+void cov_init(cov_db *db);
+
+void cov_sample(cov_db *db, uint32_t x, int stall);
+
+// Adds the hits of src into dst
+void cov_merge(cov_db *dst, const cov_db *src);
+
+int cov_bins();
+int cov_covered(const cov_db *db);
+bool cov_closed(const cov_db *db);
+
+// Picks an empty bin at random; returns false once coverage is closed
+bool cov_pick_hole(const cov_db *db, cov_target *target, unsigned *rng);
+
+// Random input that lands in the target bin's class and sign
+uint32_t cov_make_input(const cov_target *target, unsigned *rng);
+
+void cov_report(const cov_db *db, const char *report_file);
+
+#endif
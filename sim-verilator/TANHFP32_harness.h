@@ -0,0 +1,131 @@
+#ifndef __TANHFP32_HARNESS_H__
+#define __TANHFP32_HARNESS_H__
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <verilated.h>
+
+// Benchmark builds leave tracing out so the measured speed is the model's own,
+// sweep and register-profile builds because a 2^32-cycle FST would not fit
+// on disk
+#if !defined(CONFIG_BENCHMARK) && !defined(CONFIG_SWEEP) &&                   \
+    !defined(CONFIG_REG_PROFILE)
+#define CONFIG_WAVE_TRACE
+#endif
+
+#ifdef CONFIG_WAVE_TRACE
+#include <verilated_fst_c.h>
+#else
+class VerilatedFstC;
+#endif
+
+// Simulation harness shared by tb_env and the testbenches of the wrapper
+// tops (TANHFP32CDC, TANHFP32Shared, the quantized TANHFP32 builds).
+//
+// tb_sim owns a verilated top of class Top with its context and wave trace.
+// tb_sim_cycle and tb_sim_reset drive the top's clock and reset, so
+// TANHFP32CDC, which has two of each, steps its clocks itself.
+
+template <class Top> struct tb_sim {
+  VerilatedContext *contextp;
+  Top *top;
+  VerilatedFstC *tfp; // NULL without a trace
+  uint64_t cycles;
+};
+
+// wave_file is only used by CONFIG_WAVE_TRACE builds; NULL for no trace
+template <class Top>
+void tb_sim_init(tb_sim<Top> *sim, const char *wave_file) {
+  memset(sim, 0, sizeof(*sim));
+  sim->contextp = new VerilatedContext;
+  sim->top = new Top{sim->contextp};
+#ifdef CONFIG_WAVE_TRACE
+  if (wave_file) {
+    sim->tfp = new VerilatedFstC;
+    sim->contextp->traceEverOn(true);
+    sim->top->trace(sim->tfp, 0);
+    sim->tfp->open(wave_file);
+  }
+#else
+  (void)wave_file;
+#endif
+}
+
+template <class Top> void tb_sim_free(tb_sim<Top> *sim) {
+#ifdef CONFIG_WAVE_TRACE
+  if (sim->tfp) {
+    sim->tfp->close();
+    delete sim->tfp;
+  }
+#endif
+  delete sim->top;
+  delete sim->contextp;
+}
+
+template <class Top> void tb_sim_dump(tb_sim<Top> *sim) {
+#ifdef CONFIG_WAVE_TRACE
+  if (sim->tfp) {
+    sim->tfp->dump(sim->contextp->time());
+    sim->contextp->timeInc(1);
+  }
+#else
+  (void)sim;
+#endif
+}
+
+// One clock cycle, ending just after the rising edge
+template <class Top> void tb_sim_cycle(tb_sim<Top> *sim) {
+  sim->top->clock = 0;
+  sim->top->eval();
+  tb_sim_dump(sim);
+  sim->top->clock = 1;
+  sim->top->eval();
+  tb_sim_dump(sim);
+  sim->cycles++;
+}
+
+// Holds reset for n cycles; they count toward cycles
+template <class Top> void tb_sim_reset(tb_sim<Top> *sim, int n) {
+  sim->top->reset = 1;
+  for (int i = 0; i < n; i++)
+    tb_sim_cycle(sim);
+  sim->top->reset = 0;
+}
+
+// Fires once a run has made no progress for limit consecutive checks, i.e.
+// a transaction was lost or the DUT deadlocked
+struct tb_watchdog {
+  uint64_t limit;
+  uint64_t idle;
+  uint64_t last;
+};
+
+inline void tb_watchdog_init(tb_watchdog *w, uint64_t limit) {
+  w->limit = limit;
+  w->idle = 0;
+  w->last = 0;
+}
+
+// progress is any count that grows with every result
+inline bool tb_watchdog_expired(tb_watchdog *w, uint64_t progress) {
+  w->idle = progress == w->last ? w->idle + 1 : 0;
+  w->last = progress;
+  return w->idle > w->limit;
+}
+
+// Mostly the polynomial range, with specials and both bypasses mixed in
+inline uint32_t tb_mixed_input(unsigned *state) {
+  static const uint32_t specials[] = {0x00000000, 0x80000000, 0x7F800000,
+                                      0xFF800000, 0x7FC00000, 0x00000001,
+                                      0x3C000000, 0x41000000};
+  int r = rand_r(state) % 100;
+  if (r < 2)
+    return specials[rand_r(state) % 8];
+  float f = (float)rand_r(state) / RAND_MAX * 20.0f - 10.0f;
+  uint32_t u;
+  memcpy(&u, &f, sizeof(u));
+  return u;
+}
+
+#endif
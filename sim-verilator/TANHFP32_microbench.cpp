@@ -0,0 +1,249 @@
+// Microbenchmarks for the software side of verification: references, ULP
+// metric, stats kernel and the bit-accurate model. Reports ns/element and
+// GB/s per input distribution, batch size and cache state, to show which
+// stage bounds exhaustive verification throughput.
+
+#include "TANHFP32_model.h"
+#include "TANHFP32_ref.h"
+#include "TANHFP32_stats.h"
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <getopt.h>
+
+// Larger than any last-level cache we run on
+#define FLUSH_BYTES (64 << 20)
+#define COLD_REPS 10
+
+enum { DIST_RANDOM, DIST_POLY, DIST_SMALL, DIST_BITS, DIST_NUM };
+static const char *dist_name[DIST_NUM] = {"random", "poly", "small", "bits"};
+
+static const int batch_sizes[] = {1 << 10, 1 << 16, 1 << 20};
+#define NUM_BATCH_SIZES (int)(sizeof(batch_sizes) / sizeof(batch_sizes[0]))
+
+struct bench_bufs {
+  float *vin;
+  float *dut;
+  float *ref;
+  float *out;
+};
+
+struct kernel {
+  const char *name;
+  // Bytes read + written per element, for GB/s
+  int bytes;
+  void (*run)(bench_bufs *b, int n);
+};
+
+static volatile uint64_t sink;
+static tanh_model model;
+static char *flush_buf;
+
+static double now_sec() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void flush_cache() {
+  for (size_t i = 0; i < FLUSH_BYTES; i += 64)
+    flush_buf[i]++;
+}
+
+static float u2f(uint32_t u) {
+  float f;
+  memcpy(&f, &u, sizeof(f));
+  return f;
+}
+
+static float rand_unit() { return (float)rand() / RAND_MAX; }
+
+static void generate(float *vin, int n, int dist) {
+  for (int i = 0; i < n; i++) {
+    switch (dist) {
+    case DIST_RANDOM:
+      // Same distribution as test_random_cases
+      vin[i] = rand_unit() * 10.0 - 1.0;
+      break;
+    case DIST_POLY:
+      // |x| in [2^-5, 8): every input goes through both FMAs
+      vin[i] = ldexpf(1.0f + rand_unit(), -5 + rand() % 8);
+      if (rand() & 1)
+        vin[i] = -vin[i];
+      break;
+    case DIST_SMALL:
+      // |x| < 2^-5: filter bypass
+      vin[i] = ldexpf(1.0f + rand_unit(), -6 - rand() % 100);
+      break;
+    default:
+      // Raw bit patterns, including NaN, Inf and subnormals
+      vin[i] = u2f(((uint32_t)rand() << 16) ^ (uint32_t)rand());
+      break;
+    }
+  }
+}
+
+static void run_glibc(bench_bufs *b, int n) {
+  tanh_ref_glibc_batch(b->vin, b->out, n);
+}
+
+static void run_cr(bench_bufs *b, int n) { tanh_ref_cr_batch(b->vin, b->out, n); }
+
+static void run_fastmath(bench_bufs *b, int n) {
+  tanh_ref_fastmath_batch(b->vin, b->out, n);
+}
+
+static void run_ulp(bench_bufs *b, int n) {
+  uint64_t sum = 0;
+  for (int i = 0; i < n; i++)
+    sum += compute_ulp(b->ref[i], b->dut[i]);
+  sink += sum;
+}
+
+static void run_stats(bench_bufs *b, int n) {
+  error_stats stats;
+  memset(&stats, 0, sizeof(stats));
+  error_stats_update(&stats, b->vin, b->dut, b->ref, n, 1e-4, 2, false);
+  sink += stats.pass;
+}
+
+static void run_model_scalar(bench_bufs *b, int n) {
+  tanh_model_batch_scalar(&model, b->vin, b->out, n);
+}
+
+static void run_model_simd(bench_bufs *b, int n) {
+  tanh_model_batch(&model, b->vin, b->out, n);
+}
+
+static const kernel kernels[] = {
+    {"glibc", 8, run_glibc},
+    {"cr", 8, run_cr},
+    {"fastmath", 8, run_fastmath},
+    {"compute_ulp", 8, run_ulp},
+    {"stats", 12, run_stats},
+    {"model_scalar", 8, run_model_scalar},
+    {"model_simd", 8, run_model_simd},
+};
+#define NUM_KERNELS (int)(sizeof(kernels) / sizeof(kernels[0]))
+
+// Hot: best of reps on a warm buffer, for at least min_time. Cold: mean of
+// COLD_REPS reps, each after a cache flush.
+static double time_kernel(const kernel *k, bench_bufs *b, int n, bool cold,
+                          double min_time) {
+  double best = 1e30, total = 0.0;
+  int reps = 0;
+
+  if (!cold)
+    k->run(b, n);
+  while (cold ? reps < COLD_REPS : (reps < 3 || total < min_time)) {
+    if (cold)
+      flush_cache();
+    double t0 = now_sec();
+    k->run(b, n);
+    double t = now_sec() - t0;
+    total += t;
+    if (t < best)
+      best = t;
+    reps++;
+  }
+  return cold ? total / reps : best;
+}
+
+static void usage(const char *prog) {
+  printf("Usage: %s [options]\n", prog);
+  printf("  --lut FILE          Coefficient file for the model (default: "
+         "lut.txt)\n");
+  printf("  --kernel NAME       Run only this kernel\n");
+  printf("  --dist NAME         Run only this input distribution\n");
+  printf("  --min-time SEC      Minimum time per measurement (default: "
+         "0.2)\n");
+}
+
+int main(int argc, char **argv) {
+  const char *lut_file = "lut.txt";
+  const char *only_kernel = NULL;
+  const char *only_dist = NULL;
+  double min_time = 0.2;
+
+  static struct option long_opts[] = {
+      {"lut", required_argument, NULL, 'l'},
+      {"kernel", required_argument, NULL, 'k'},
+      {"dist", required_argument, NULL, 'd'},
+      {"min-time", required_argument, NULL, 'm'},
+      {"help", no_argument, NULL, 'h'},
+      {NULL, 0, NULL, 0}};
+  int opt;
+  while ((opt = getopt_long(argc, argv, "h", long_opts, NULL)) != -1) {
+    switch (opt) {
+    case 'l':
+      lut_file = optarg;
+      break;
+    case 'k':
+      only_kernel = optarg;
+      break;
+    case 'd':
+      only_dist = optarg;
+      break;
+    case 'm':
+      min_time = atof(optarg);
+      break;
+    default:
+      usage(argv[0]);
+      return opt == 'h' ? 0 : 1;
+    }
+  }
+
+  tanh_model_init(&model);
+  if (!tanh_model_load_lut(&model, lut_file))
+    return 1;
+
+  int max_n = batch_sizes[NUM_BATCH_SIZES - 1];
+  bench_bufs b;
+  b.vin = (float *)malloc(sizeof(float) * max_n);
+  b.dut = (float *)malloc(sizeof(float) * max_n);
+  b.ref = (float *)malloc(sizeof(float) * max_n);
+  b.out = (float *)malloc(sizeof(float) * max_n);
+  flush_buf = (char *)calloc(FLUSH_BYTES, 1);
+  srand(1);
+
+#if defined(__AVX2__) && defined(__FMA__)
+  printf("model_simd: AVX2 + FMA\n");
+#else
+  printf("model_simd: scalar fallback (build with -mavx2 -mfma)\n");
+#endif
+  printf("\n%-13s %-7s %8s %5s %10s %9s\n", "Kernel", "Dist", "Batch", "Cache",
+         "ns/elem", "GB/s");
+  printf("-------------------------------------------------------------\n");
+
+  for (int d = 0; d < DIST_NUM; d++) {
+    if (only_dist && strcmp(only_dist, dist_name[d]))
+      continue;
+    generate(b.vin, max_n, d);
+    tanh_model_batch_scalar(&model, b.vin, b.dut, max_n);
+    tanh_ref_glibc_batch(b.vin, b.ref, max_n);
+
+    for (int k = 0; k < NUM_KERNELS; k++) {
+      if (only_kernel && strcmp(only_kernel, kernels[k].name))
+        continue;
+      for (int s = 0; s < NUM_BATCH_SIZES; s++) {
+        int n = batch_sizes[s];
+        for (int cold = 0; cold <= 1; cold++) {
+          double t = time_kernel(&kernels[k], &b, n, cold, min_time);
+          printf("%-13s %-7s %8d %5s %10.3f %9.3f\n", kernels[k].name,
+                 dist_name[d], n, cold ? "cold" : "hot", t * 1e9 / n,
+                 (double)kernels[k].bytes * n / t * 1e-9);
+        }
+      }
+    }
+  }
+
+  free(b.vin);
+  free(b.dut);
+  free(b.ref);
+  free(b.out);
+  free(flush_buf);
+  return 0;
+}
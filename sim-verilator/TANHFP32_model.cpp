@@ -0,0 +1,470 @@
+#include "TANHFP32_model.h"
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#if defined(__AVX2__) && defined(__FMA__)
+#include <immintrin.h>
+#endif
+
+#define MODEL_ONE 0x3F800000u
+#define MODEL_NAN 0x7FC00000u
+
+// Polynomial domain is e_unbias in [-5, 3), i.e. biased exponent [122, 130)
+#define MODEL_EXP_MIN 122
+#define MODEL_EXP_MAX 130
+
+#define MODEL_DEFAULT_SEG_BITS 3
+
+static inline float u2f(uint32_t u) {
+  float f;
+  memcpy(&f, &u, sizeof(f));
+  return f;
+}
+
+static inline uint32_t f2u(float f) {
+  uint32_t u;
+  memcpy(&u, &f, sizeof(u));
+  return u;
+}
+
+// Every step is an fmaf (or its muladd form), which the AVX2 path also does
+static inline bool exact_datapath(const tanh_model *m) {
+  return m->mul_trunc == 0 && m->add_width == TANH_MODEL_FULL_ADD_WIDTH &&
+         m->fwd_width == TANH_MODEL_MIN_FWD_WIDTH;
+}
+
+// Significand product of the truncated array: partial-product bits below
+// column mul_trunc are dropped and the compensation constant added back
+static uint64_t trunc_product(const tanh_model *m, uint32_t sa, uint32_t sb) {
+  uint64_t keep = ~((1ull << m->mul_trunc) - 1);
+  uint64_t p = 0;
+  for (int i = 0; i < 24; i++)
+    if ((sb >> i) & 1)
+      p += ((uint64_t)sa << i) & keep;
+  return p + m->mul_comp;
+}
+
+// Keeps the top add_width bits and ORs the rest into the lowest kept bit,
+// as the narrowed FCMA_ADD input does
+static uint64_t jam_product(const tanh_model *m, uint64_t p) {
+  int drop = 64 - __builtin_clzll(p) - m->add_width;
+  if (drop <= 0)
+    return p;
+  uint64_t low = p & ((1ull << drop) - 1);
+  return (p >> drop << drop) | (low ? 1ull << drop : 0);
+}
+
+// p + c rounded once to float: p has at most 50 significant bits, so the
+// double sum rounded to odd and then to float is the correctly rounded sum
+static float add_round_once(double p, float c) {
+  double s = p + (double)c;
+  double bb = s - p;
+  double err = (p - (s - bb)) + ((double)c - bb);
+  uint64_t bits;
+  memcpy(&bits, &s, sizeof(bits));
+  if (err != 0 && !(bits & 1))
+    s = nextafter(s, err > 0 ? INFINITY : -INFINITY);
+  return (float)s;
+}
+
+// Horner step through the truncated multiplier and the narrowed adder
+static float horner_step_trunc(const tanh_model *m, float x, float acc,
+                               float c) {
+  uint32_t xb = f2u(x), ab = f2u(acc);
+  uint32_t xe = (xb >> 23) & 0xFF, ae = (ab >> 23) & 0xFF;
+  // Zero, subnormal and non-finite accumulators take the exact path; the
+  // polynomial never produces them
+  if (ae == 0 || ae == 0xFF)
+    return m->engine == TANH_ENGINE_FMA ? fmaf(x, acc, c)
+                                           : fmaf(x, acc, -0.0f) + c;
+  uint64_t p = trunc_product(m, (xb & 0x7FFFFF) | 0x800000,
+                             (ab & 0x7FFFFF) | 0x800000);
+  double sign = (ab >> 31) ? -1.0 : 1.0;
+  int exp = (int)xe + (int)ae - 2 * 127 - 46;
+  if (m->engine == TANH_ENGINE_MULADD)
+    return (float)(sign * ldexp((double)p, exp)) + c;
+  return add_round_once(sign * ldexp((double)jam_product(m, p), exp), c);
+}
+
+// One Horner step: fused, or product rounded before the add. fmaf with a -0
+// addend rounds the product alone and cannot be contracted back into an FMA.
+static inline float horner_step(const tanh_model *m, float x, float acc,
+                                float c) {
+  if (!exact_datapath(m))
+    return horner_step_trunc(m, x, acc, c);
+  if (m->engine == TANH_ENGINE_FMA)
+    return fmaf(x, acc, c);
+  return fmaf(x, acc, -0.0f) + c;
+}
+
+// hi + lo, the exact sum from a two-sum (|lo| <= ulp(hi) / 2), rounded to
+// nearest even at p < 53 significand bits. Only a tie on hi can be moved by
+// lo: otherwise hi is at least an ulp of itself away from the midpoint.
+static double round_sum(double hi, double lo, int p) {
+  if (hi == 0)
+    return hi;
+  double q = ldexp(1.0, ilogb(hi) - p + 1);
+  double r = nearbyint(hi / q) * q;
+  double a = hi - r;
+  if (fabs(a) == q / 2 && lo != 0 && (lo > 0) == (a > 0))
+    r += 2 * a;
+  return r;
+}
+
+// Horner with the accumulator forwarded at fwd_width bits and rounded to
+// FP32 only in the last step. acc has at most 29 bits and x 24, so each
+// product is exact in a double and the two-sum keeps all of c + x * acc.
+// At fwd_width 24 this is the fmaf chain the batch path runs, computed
+// independently, which is what ulpsweep --check-scalar compares.
+static float horner_forward(const tanh_model *m, float x, int region) {
+  double acc = m->lut_c[m->degree][region];
+  for (int k = m->degree - 1; k >= 0; k--) {
+    double p = (double)x * acc;
+    double c = m->lut_c[k][region];
+    double s = p + c;
+    double bb = s - p;
+    double err = (p - (s - bb)) + (c - bb);
+    acc = round_sum(s, err, k ? m->fwd_width : TANH_MODEL_MIN_FWD_WIDTH);
+  }
+  return (float)acc;
+}
+
+void tanh_model_init(tanh_model *m) {
+  memset(m, 0, sizeof(*m));
+  m->seg_bits = MODEL_DEFAULT_SEG_BITS;
+  m->degree = 2;
+  m->engine = TANH_ENGINE_FMA;
+  m->add_width = TANH_MODEL_FULL_ADD_WIDTH;
+  m->fwd_width = TANH_MODEL_MIN_FWD_WIDTH;
+}
+
+bool tanh_model_configure(tanh_model *m, int seg_bits, int degree,
+                          int engine) {
+  if (seg_bits < 0 || seg_bits > TANH_MODEL_MAX_SEG_BITS || degree < 1 ||
+      degree > TANH_MODEL_MAX_DEGREE ||
+      (engine != TANH_ENGINE_FMA && engine != TANH_ENGINE_MULADD)) {
+    printf("Warning: Unsupported model configuration seg_bits=%d degree=%d "
+           "engine=%d.\n",
+           seg_bits, degree, engine);
+    return false;
+  }
+  m->seg_bits = seg_bits;
+  m->degree = degree;
+  m->engine = engine;
+  return true;
+}
+
+bool tanh_model_configure_datapath(tanh_model *m, int mul_trunc,
+                                   int add_width, int fwd_width) {
+  bool forward = fwd_width != TANH_MODEL_MIN_FWD_WIDTH;
+  if (mul_trunc < 0 || mul_trunc > TANH_MODEL_MAX_MUL_TRUNC ||
+      add_width < TANH_MODEL_MIN_ADD_WIDTH ||
+      add_width > TANH_MODEL_FULL_ADD_WIDTH ||
+      fwd_width < TANH_MODEL_MIN_FWD_WIDTH ||
+      fwd_width > TANH_MODEL_MAX_FWD_WIDTH ||
+      (forward && (mul_trunc || add_width != TANH_MODEL_FULL_ADD_WIDTH ||
+                   m->engine != TANH_ENGINE_FMA))) {
+    printf("Warning: Unsupported datapath mul_trunc=%d add_width=%d "
+           "fwd_width=%d.\n",
+           mul_trunc, add_width, fwd_width);
+    return false;
+  }
+  m->mul_trunc = mul_trunc;
+  m->add_width = add_width;
+  m->fwd_width = fwd_width;
+  // Expected value of the dropped bits, a quarter per bit, to the nearest
+  // multiple of 2^mul_trunc; same constant as TruncMultiplier
+  m->mul_comp = mul_trunc ? (uint64_t)((mul_trunc + 1) / 4) << mul_trunc : 0;
+  return true;
+}
+
+bool tanh_model_load_lut(tanh_model *m, const char *filename) {
+  FILE *fp = fopen(filename, "r");
+  if (!fp) {
+    printf("Warning: Failed to open LUT file %s.\n", filename);
+    return false;
+  }
+
+  int regions = 8 << m->seg_bits;
+  int count = 0;
+  char line[256];
+  while (fgets(line, sizeof(line), fp)) {
+    char *p = line, *end;
+    int idx = strtol(p, &end, 10);
+    if (end == p || idx < 0 || idx >= regions)
+      continue;
+    int k = 0;
+    for (p = end; k <= m->degree; k++, p = end) {
+      while (*p == ' ' || *p == '\t')
+        p++;
+      if (*p++ != 'h')
+        break;
+      m->lut_c[k][idx] = u2f(strtoul(p, &end, 16));
+    }
+    if (k == m->degree + 1)
+      count++;
+  }
+  fclose(fp);
+
+  if (count != regions) {
+    printf("Warning: LUT file %s has %d of %d degree-%d entries.\n", filename,
+           count, regions, m->degree);
+    return false;
+  }
+  return true;
+}
+
+bool tanh_model_load_fixup(tanh_model *m, const char *filename) {
+  m->fixup_count = 0;
+  if (!filename)
+    return true;
+  FILE *fp = fopen(filename, "r");
+  if (!fp) {
+    printf("Warning: Failed to open fix-up file %s.\n", filename);
+    return false;
+  }
+
+  char line[256];
+  bool ok = true;
+  while (ok && fgets(line, sizeof(line), fp)) {
+    char *p = line, *end;
+    while (*p == ' ' || *p == '\t')
+      p++;
+    if (*p == '\n' || *p == '\0')
+      continue;
+    uint32_t in = 0, out = 0;
+    ok = *p++ == 'h';
+    if (ok) {
+      in = strtoul(p, &end, 16);
+      for (p = end; *p == ' ' || *p == '\t'; p++)
+        ;
+      ok = *p++ == 'h';
+      out = strtoul(p, &end, 16);
+    }
+    ok = ok && tanh_model_bypass(in) == TANH_BYPASS_NONE && !(in >> 31) &&
+         !(out >> 31) && m->fixup_count < TANH_MODEL_MAX_FIXUPS;
+    if (!ok) {
+      printf("Warning: Fix-up file %s: bad entry or more than %d entries: %s",
+             filename, TANH_MODEL_MAX_FIXUPS, line);
+      break;
+    }
+    // Insertion keeps the table sorted. A repeated key is an error, as in
+    // the generator: two CAM hits would OR their outputs.
+    int j = m->fixup_count;
+    while (j > 0 && m->fixup_in[j - 1] > in)
+      j--;
+    if (j > 0 && m->fixup_in[j - 1] == in) {
+      printf("Warning: Fix-up file %s: duplicate key h%08x.\n", filename, in);
+      ok = false;
+      break;
+    }
+    memmove(&m->fixup_in[j + 1], &m->fixup_in[j],
+            (m->fixup_count - j) * sizeof(uint32_t));
+    memmove(&m->fixup_out[j + 1], &m->fixup_out[j],
+            (m->fixup_count - j) * sizeof(uint32_t));
+    m->fixup_in[j] = in;
+    m->fixup_out[j] = out;
+    m->fixup_count++;
+  }
+  fclose(fp);
+  if (!ok)
+    m->fixup_count = 0;
+  return ok;
+}
+
+// Index of |x| in the fix-up table, or -1
+static int fixup_find(const tanh_model *m, uint32_t x_abs) {
+  int lo = 0, hi = m->fixup_count;
+  while (lo < hi) {
+    int mid = (lo + hi) / 2;
+    if (m->fixup_in[mid] < x_abs)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+  return lo < m->fixup_count && m->fixup_in[lo] == x_abs ? lo : -1;
+}
+
+int tanh_model_bypass(uint32_t x) {
+  uint32_t exp = (x >> 23) & 0xFF;
+  uint32_t frac = x & 0x7FFFFF;
+
+  if (exp == 0xFF)
+    return frac ? TANH_BYPASS_NAN : TANH_BYPASS_INF;
+  if (exp == 0)
+    return frac ? TANH_BYPASS_SUBNORM : TANH_BYPASS_ZERO;
+  if (exp < MODEL_EXP_MIN)
+    return TANH_BYPASS_SMALL;
+  if (exp >= MODEL_EXP_MAX)
+    return TANH_BYPASS_LARGE;
+  return TANH_BYPASS_NONE;
+}
+
+static inline int region_of(uint32_t x, int seg_bits) {
+  uint32_t exp = (x >> 23) & 0xFF;
+  uint32_t frac = x & 0x7FFFFF;
+  return ((exp - MODEL_EXP_MIN) << seg_bits) | (frac >> (23 - seg_bits));
+}
+
+int tanh_model_region(const tanh_model *m, uint32_t x) {
+  return region_of(x, m->seg_bits);
+}
+
+int tanh_input_class(uint32_t x) {
+  int bypass = tanh_model_bypass(x);
+  if (bypass == TANH_BYPASS_NONE)
+    return region_of(x, MODEL_DEFAULT_SEG_BITS);
+  return TANH_MODEL_REGIONS + bypass - 1;
+}
+
+void tanh_input_class_name(int cls, char *buf, int len) {
+  static const char *bypass_name[TANH_BYPASS_NUM] = {
+      "none", "nan", "inf", "zero", "subnorm", "small", "large"};
+  if (cls < TANH_MODEL_REGIONS)
+    snprintf(buf, len, "region%02d", cls);
+  else
+    snprintf(buf, len, "%s", bypass_name[cls - TANH_MODEL_REGIONS + 1]);
+}
+
+uint32_t tanh_model_eval(const tanh_model *m, uint32_t x) {
+  uint32_t sign = x & 0x80000000u;
+  uint32_t exp = (x >> 23) & 0xFF;
+  uint32_t frac = x & 0x7FFFFF;
+
+  // Filter: NaN, then zero/subnormal and |x| < 2^-5 pass through, then
+  // Inf and |x| >= 8 saturate
+  if (exp == 0xFF && frac != 0)
+    return MODEL_NAN;
+  if (exp < MODEL_EXP_MIN)
+    return x;
+  if (exp >= MODEL_EXP_MAX)
+    return sign | MODEL_ONE;
+
+  // Fix-up hits bypass the polynomial like the filter's own bypasses
+  int fix = fixup_find(m, x & 0x7FFFFFFF);
+  if (fix >= 0)
+    return m->fixup_out[fix] | sign;
+
+  uint32_t region = tanh_model_region(m, x);
+  float xAbs = u2f(x & 0x7FFFFFFF);
+  if (m->engine == TANH_ENGINE_FMA && m->mul_trunc == 0 &&
+      m->add_width == TANH_MODEL_FULL_ADD_WIDTH)
+    return f2u(horner_forward(m, xAbs, region)) | sign;
+  float y = m->lut_c[m->degree][region];
+  for (int k = m->degree - 1; k >= 0; k--)
+    y = horner_step(m, xAbs, y, m->lut_c[k][region]);
+  return f2u(y) | sign;
+}
+
+int tanh_format_width(int format) {
+  switch (format) {
+  case TANH_FMT_BF16:
+  case TANH_FMT_INT16:
+    return 16;
+  case TANH_FMT_INT8:
+    return 8;
+  default:
+    return 32;
+  }
+}
+
+uint32_t tanh_model_fixed_to_fp32(int32_t q, int frac) {
+  return f2u(ldexpf((float)q, -frac));
+}
+
+uint32_t tanh_model_convert_out(uint32_t y, int format, int frac) {
+  bool is_nan = (y & 0x7FFFFFFF) > 0x7F800000;
+  if (format == TANH_FMT_BF16)
+    return is_nan ? (y & 0x80000000) >> 16 | 0x7FC0
+                  : (y + 0x7FFF + ((y >> 16) & 1)) >> 16;
+  if (format == TANH_FMT_FP32)
+    return y;
+  if (is_nan)
+    return 0;
+  int width = tanh_format_width(format);
+  double max = ldexp(1.0, width - 1) - 1;
+  // Exact: a float scaled by at most 2^15 is representable in a double
+  double v = rint(ldexp((double)u2f(y), frac));
+  v = v > max ? max : v < -max - 1 ? -max - 1 : v;
+  return (uint32_t)(int32_t)v & ((1u << width) - 1);
+}
+
+void tanh_model_batch_scalar(const tanh_model *m, const float *vin,
+                             float *vout, int n) {
+  for (int i = 0; i < n; i++)
+    vout[i] = u2f(tanh_model_eval(m, f2u(vin[i])));
+}
+
+#if defined(__AVX2__) && defined(__FMA__)
+void tanh_model_batch(const tanh_model *m, const float *vin, float *vout,
+                      int n) {
+  if (!exact_datapath(m)) {
+    tanh_model_batch_scalar(m, vin, vout, n);
+    return;
+  }
+  const __m256i sign_mask = _mm256_set1_epi32(0x80000000);
+  const __m256i abs_mask = _mm256_set1_epi32(0x7FFFFFFF);
+  const __m256i frac_mask = _mm256_set1_epi32(0x7FFFFF);
+  const __m256i exp_mask = _mm256_set1_epi32(0xFF);
+  const __m256i exp_min = _mm256_set1_epi32(MODEL_EXP_MIN);
+  const __m256i exp_large = _mm256_set1_epi32(MODEL_EXP_MAX - 1);
+  const __m256i exp_special = _mm256_set1_epi32(0xFF);
+  const __m256i seven = _mm256_set1_epi32(7);
+  const __m128i seg_shift = _mm_cvtsi32_si128(m->seg_bits);
+  const __m128i frac_shift = _mm_cvtsi32_si128(23 - m->seg_bits);
+  const __m256 neg_zero = _mm256_set1_ps(-0.0f);
+  const __m256i one = _mm256_set1_epi32(MODEL_ONE);
+  const __m256i nan = _mm256_set1_epi32(MODEL_NAN);
+  const __m256i zero = _mm256_setzero_si256();
+
+  int i = 0;
+  for (; i + 8 <= n; i += 8) {
+    __m256i x = _mm256_loadu_si256((const __m256i *)(vin + i));
+    __m256i sign = _mm256_and_si256(x, sign_mask);
+    __m256i xabs = _mm256_and_si256(x, abs_mask);
+    __m256i exp = _mm256_and_si256(_mm256_srli_epi32(x, 23), exp_mask);
+    __m256i frac = _mm256_and_si256(x, frac_mask);
+
+    // Out-of-domain lanes still index inside the table; their result is
+    // replaced by the bypass value below
+    __m256i e_off = _mm256_and_si256(_mm256_sub_epi32(exp, exp_min), seven);
+    __m256i region = _mm256_or_si256(_mm256_sll_epi32(e_off, seg_shift),
+                                     _mm256_srl_epi32(frac, frac_shift));
+
+    __m256 a = _mm256_castsi256_ps(xabs);
+    __m256 y = _mm256_i32gather_ps(m->lut_c[m->degree], region, 4);
+    for (int k = m->degree - 1; k >= 0; k--) {
+      __m256 c = _mm256_i32gather_ps(m->lut_c[k], region, 4);
+      if (m->engine == TANH_ENGINE_FMA)
+        y = _mm256_fmadd_ps(a, y, c);
+      else
+        y = _mm256_add_ps(_mm256_fmadd_ps(a, y, neg_zero), c);
+    }
+    __m256i r = _mm256_or_si256(_mm256_castps_si256(y), sign);
+
+    __m256i small = _mm256_cmpgt_epi32(exp_min, exp);
+    __m256i large = _mm256_cmpgt_epi32(exp, exp_large);
+    __m256i is_nan =
+        _mm256_andnot_si256(_mm256_cmpeq_epi32(frac, zero),
+                            _mm256_cmpeq_epi32(exp, exp_special));
+    r = _mm256_blendv_epi8(r, x, small);
+    r = _mm256_blendv_epi8(r, _mm256_or_si256(sign, one), large);
+    r = _mm256_blendv_epi8(r, nan, is_nan);
+    _mm256_storeu_si256((__m256i *)(vout + i), r);
+  }
+  // Keys are inside the polynomial domain, so a hit replaces a polynomial lane
+  for (int j = 0; m->fixup_count && j < i; j++) {
+    uint32_t x = f2u(vin[j]);
+    int fix = fixup_find(m, x & 0x7FFFFFFF);
+    if (fix >= 0)
+      vout[j] = u2f(m->fixup_out[fix] | (x & 0x80000000u));
+  }
+  tanh_model_batch_scalar(m, vin + i, vout + i, n - i);
+}
+#else
+void tanh_model_batch(const tanh_model *m, const float *vin, float *vout,
+                      int n) {
+  tanh_model_batch_scalar(m, vin, vout, n);
+}
+#endif
@@ -0,0 +1,129 @@
+#ifndef __TANHFP32_MODEL_H__
+#define __TANHFP32_MODEL_H__
+
+#include <cstdint>
+
+// Bit-accurate software model of the TANHFP32 datapath.
+//
+// The filter, segment index and LUT follow src/scala/TANHFP32.scala. Each
+// CMAFP32 multiplies exactly and rounds once (RNE) in FCMA_ADD_s2, so every
+// Horner step is a single fmaf; the muladd engine rounds the product first.
+// Only rm = 0 is modelled.
+//
+// All state lives in a tanh_model, so one process can hold models of several
+// generator configurations side by side. tanh_model_init gives the default
+// configuration (3 segment bits, degree 2, fma), the one the committed RTL is
+// generated with; tanh_model_configure selects another before the LUT is
+// loaded. A loaded model is only read, so threads may share it.
+
+// Regions of the default configuration, which the coverage model bins
+#define TANH_MODEL_REGIONS 64
+
+#define TANH_MODEL_MAX_SEG_BITS 6
+#define TANH_MODEL_MAX_DEGREE 3
+#define TANH_MODEL_MAX_REGIONS (8 << TANH_MODEL_MAX_SEG_BITS)
+
+enum { TANH_ENGINE_FMA, TANH_ENGINE_MULADD };
+
+// Truncated datapath (TANHFP32Config.mulTrunc/addWidth): product columns
+// dropped by the multiplier, and product significand bits into the FMA adder
+#define TANH_MODEL_MAX_MUL_TRUNC 24
+#define TANH_MODEL_MIN_ADD_WIDTH 26
+#define TANH_MODEL_FULL_ADD_WIDTH 48
+
+// Forwarded accumulator (TANHFP32Config.fwdWidth): significand bits of the
+// value one Horner step hands to the next; 24 rounds it to FP32
+#define TANH_MODEL_MIN_FWD_WIDTH 24
+#define TANH_MODEL_MAX_FWD_WIDTH 29
+
+// Fix-up table (TANHFP32Config.fixupFile): |x| -> |tanh(x)| pairs that
+// replace the polynomial for single inputs
+#define TANH_MODEL_MAX_FIXUPS 1024
+
+// Why the filter bypasses the polynomial, in the filter's priority order
+enum {
+  TANH_BYPASS_NONE,
+  TANH_BYPASS_NAN,
+  TANH_BYPASS_INF,
+  TANH_BYPASS_ZERO,
+  TANH_BYPASS_SUBNORM,
+  TANH_BYPASS_SMALL,
+  TANH_BYPASS_LARGE,
+  TANH_BYPASS_NUM
+};
+
+struct tanh_model {
+  int seg_bits;
+  int degree;
+  int engine;
+  int mul_trunc;
+  int add_width;
+  int fwd_width;
+  uint64_t mul_comp; // TruncMultiplier's compensation constant
+  float lut_c[TANH_MODEL_MAX_DEGREE + 1][TANH_MODEL_MAX_REGIONS];
+  // Sorted by key for the binary search; the RTL compares all keys at once
+  uint32_t fixup_in[TANH_MODEL_MAX_FIXUPS];
+  uint32_t fixup_out[TANH_MODEL_MAX_FIXUPS];
+  int fixup_count;
+};
+
+// Default configuration, FP32 datapath, no LUT or fix-ups loaded
+void tanh_model_init(tanh_model *m);
+
+// Same parameters as TANHFP32Config; returns false if out of range
+bool tanh_model_configure(tanh_model *m, int seg_bits, int degree,
+                          int engine);
+
+// Same parameters as TANHFP32Config.mulTrunc/addWidth/fwdWidth; (0, 48, 24)
+// is the FP32 datapath, and a wider fwd_width needs (0, 48) and fma
+bool tanh_model_configure_datapath(tanh_model *m, int mul_trunc,
+                                   int add_width, int fwd_width);
+
+// Loads coefficients in the lut.txt format (index, then c0..c<degree>);
+// must be called before use
+bool tanh_model_load_lut(tanh_model *m, const char *filename);
+
+// Loads a fix-up table, one "h<|x|> h<|y|>" pair per line, keys inside the
+// polynomial domain, each at most once; an empty file or NULL clears it
+bool tanh_model_load_fixup(tanh_model *m, const char *filename);
+
+uint32_t tanh_model_eval(const tanh_model *m, uint32_t x);
+
+int tanh_model_bypass(uint32_t x);
+
+// LUT region of an input the filter does not bypass
+int tanh_model_region(const tanh_model *m, uint32_t x);
+
+// Input classes the coverage and sequential models bin by: the regions of
+// the default configuration, then one per bypass reason
+#define TANH_INPUT_CLASSES (TANH_MODEL_REGIONS + TANH_BYPASS_NUM - 1)
+
+int tanh_input_class(uint32_t x);
+
+// "region05", "nan", "small", ...
+void tanh_input_class_name(int cls, char *buf, int len);
+
+// Data formats of TANHFP32Config.inFormat/outFormat. Macros rather than an
+// enum so the quantized testbench can select ports with #if.
+#define TANH_FMT_FP32 0
+#define TANH_FMT_BF16 1
+#define TANH_FMT_INT8 2
+#define TANH_FMT_INT16 3
+
+int tanh_format_width(int format);
+
+// Fixed-point input q * 2^-frac (q sign-extended) to FP32, exact
+uint32_t tanh_model_fixed_to_fp32(int32_t q, int frac);
+
+// FP32 result to the output format, rounded once to nearest even; integers
+// are scaled by 2^frac, saturated and returned as width-bit two's complement
+uint32_t tanh_model_convert_out(uint32_t y, int format, int frac);
+
+void tanh_model_batch_scalar(const tanh_model *m, const float *vin,
+                             float *vout, int n);
+
+// AVX2 + FMA gather version when the host supports it, scalar otherwise
+void tanh_model_batch(const tanh_model *m, const float *vin, float *vout,
+                      int n);
+
+#endif
@@ -0,0 +1,251 @@
+#include "TANHFP32_pipeprof.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <verilated_syms.h>
+
+#define TOP_SCOPE "TOP.TANHFP32"
+#define VALID_MARK "Pipe_rValid"
+// filter, segment, lut, up to three CMAs of 5 stages, sOut
+#define MAX_STAGES 32
+
+struct pipe_stage {
+  // Instance path below the top and stage, as in the register profile
+  char name[48];
+  // Datapath position: block, then unit inside a CMA, then stage number
+  int block, unit, index;
+  const uint8_t *valid;
+  uint64_t occupied;
+  uint64_t stalled;
+  uint64_t bubbles;
+  // Origin of the bubble currently held by this stage
+  int bubble_origin;
+};
+
+enum { ORIGIN_IDLE, ORIGIN_DRAIN, ORIGIN_NUM };
+static const char *origin_name[ORIGIN_NUM] = {"input idle", "drain"};
+
+// Found by walking the scope table, sorted upstream to downstream
+static pipe_stage stages[MAX_STAGES];
+static pipe_stage *active[MAX_STAGES];
+static int num_active = 0;
+
+// filter, segment and lut come first, then cma<i> in Horner order, then the
+// top's own output register. Inside a CMA the MULFP32 stages precede the
+// adder's, whether those sit in the CMA (fma) or in its ADDFP32 (muladd).
+static void stage_position(pipe_stage *s, const char *inst, const char *stage) {
+  static const char *front[] = {"filter", "segment", "lut"};
+  size_t len = strcspn(inst, ".");
+  s->block = MAX_STAGES;
+  for (int i = 0; i < 3; i++)
+    if (len == strlen(front[i]) && !strncmp(inst, front[i], len))
+      s->block = i;
+  if (!strncmp(inst, "cma", 3) && len > 3)
+    s->block = 3 + atoi(inst + 3);
+  s->unit = strcmp(inst + len, ".mul") ? 1 : 0;
+  s->index = stage[0] == 's' ? atoi(stage + 1) : 0;
+}
+
+static int stage_cmp(const void *a, const void *b) {
+  const pipe_stage *x = (const pipe_stage *)a, *y = (const pipe_stage *)b;
+  if (x->block != y->block)
+    return x->block - y->block;
+  if (x->unit != y->unit)
+    return x->unit - y->unit;
+  return x->index - y->index;
+}
+
+static uint64_t cycles = 0;
+static uint64_t in_fires = 0;
+static uint64_t in_stalls = 0;
+static uint64_t out_fires = 0;
+static uint64_t out_stalls = 0;
+static uint64_t bubble_origin_count[ORIGIN_NUM];
+// Stage-cycles lost to a stall, by the stage whose consumer deasserted ready
+static uint64_t stall_origin_count[MAX_STAGES];
+
+static FILE *trace_fp = NULL;
+static uint64_t trace_limit = 0;
+
+bool pipeprof_init(VerilatedContext *contextp, const char *trace_file,
+                   uint64_t trace_cycles) {
+  const VerilatedScopeNameMap *scopes = contextp->scopeNameMap();
+  int found = 0;
+  for (const auto &sc : *scopes) {
+    const char *scope = sc.first;
+    const VerilatedScope *scopep = sc.second;
+    if (strncmp(scope, TOP_SCOPE, strlen(TOP_SCOPE)) || !scopep->varsp())
+      continue;
+    const char *inst = scope + strlen(TOP_SCOPE);
+    inst += *inst == '.';
+    for (auto &v : *scopep->varsp()) {
+      const char *name = v.first;
+      const char *mark = strstr(name, VALID_MARK);
+      if (!mark || mark[strlen(VALID_MARK)] != '\0')
+        continue;
+      if (found == MAX_STAGES) {
+        printf("Error: Pipeline profile: more than %d stages\n", MAX_STAGES);
+        return false;
+      }
+      pipe_stage *s = &stages[found++];
+      int len = (int)(mark - name);
+      if (*inst)
+        snprintf(s->name, sizeof(s->name), "%s.%.*s", inst, len, name);
+      else
+        snprintf(s->name, sizeof(s->name), "%.*s", len, name);
+      char stage[16];
+      snprintf(stage, sizeof(stage), "%.*s", len, name);
+      stage_position(s, inst, stage);
+      s->valid = (const uint8_t *)v.second.datap();
+      s->bubble_origin = ORIGIN_IDLE;
+    }
+  }
+  if (found == 0) {
+    printf("Warning: No pipeline registers found; was the model verilated "
+           "with --public-flat-rw?\n");
+    return false;
+  }
+  qsort(stages, found, sizeof(pipe_stage), stage_cmp);
+  for (int i = 0; i < found; i++) {
+    // Two registers at one position would make the ready chain ambiguous
+    if (i > 0 && !stage_cmp(&stages[i - 1], &stages[i])) {
+      printf("Error: Pipeline profile: cannot order %s and %s\n",
+             stages[i - 1].name, stages[i].name);
+      num_active = 0;
+      return false;
+    }
+    active[num_active++] = &stages[i];
+  }
+  printf("Pipeline profile: %d stages\n", num_active);
+
+  if (trace_file) {
+    trace_fp = fopen(trace_file, "w");
+    if (!trace_fp) {
+      printf("Warning: Failed to open pipeline trace %s.\n", trace_file);
+    } else {
+      // One line per cycle: input, one column per stage, output.
+      // '.' empty, '=' holds a transaction that moves on, 'S' stalled,
+      // '>' port fires
+      fprintf(trace_fp, "# stages: io.in");
+      for (int k = 0; k < num_active; k++)
+        fprintf(trace_fp, " %s", active[k]->name);
+      fprintf(trace_fp, " io.out\n");
+      trace_limit = trace_cycles;
+    }
+  }
+  return true;
+}
+
+void pipeprof_sample(bool in_valid, bool out_ready, bool draining) {
+  bool valid[MAX_STAGES];
+  bool down_ready[MAX_STAGES];
+  char line[MAX_STAGES + 3];
+
+  bool ready = out_ready;
+  bool any_valid = false;
+  for (int k = num_active - 1; k >= 0; k--) {
+    valid[k] = *active[k]->valid & 1;
+    down_ready[k] = ready;
+    ready = !valid[k] || ready;
+    any_valid |= valid[k];
+  }
+  bool in_ready = ready;
+
+  for (int k = 0; k < num_active; k++) {
+    pipe_stage *s = active[k];
+    if (valid[k]) {
+      s->occupied++;
+      if (!down_ready[k]) {
+        s->stalled++;
+        // Follow the run of full stages to the consumer that blocks it
+        int m = k;
+        while (m + 1 < num_active && !down_ready[m] && valid[m + 1] &&
+               !down_ready[m + 1])
+          m++;
+        stall_origin_count[m]++;
+      }
+      line[k + 1] = down_ready[k] ? '=' : 'S';
+    } else {
+      if (any_valid) {
+        s->bubbles++;
+        bubble_origin_count[s->bubble_origin]++;
+      }
+      line[k + 1] = '.';
+    }
+  }
+
+  // Valid state after this edge, to carry bubble origins down the pipe
+  for (int k = num_active - 1; k >= 0; k--) {
+    bool up_valid = k == 0 ? in_valid : valid[k - 1];
+    bool next_valid = up_valid ? true : (valid[k] && !down_ready[k]);
+    if (!next_valid) {
+      if (k == 0)
+        active[k]->bubble_origin = draining ? ORIGIN_DRAIN : ORIGIN_IDLE;
+      else
+        active[k]->bubble_origin = active[k - 1]->bubble_origin;
+    }
+  }
+
+  bool out_valid = valid[num_active - 1];
+  in_fires += in_valid && in_ready;
+  in_stalls += in_valid && !in_ready;
+  out_fires += out_valid && out_ready;
+  out_stalls += out_valid && !out_ready;
+
+  if (trace_fp && cycles < trace_limit) {
+    line[0] = !in_valid ? '.' : (in_ready ? '>' : 'S');
+    line[num_active + 1] = !out_valid ? '.' : (out_ready ? '>' : 'S');
+    line[num_active + 2] = '\0';
+    fprintf(trace_fp, "%s\n", line);
+  }
+  cycles++;
+}
+
+static void print_report(FILE *fp) {
+  fprintf(fp, "\n=== Pipeline Occupancy ===\n");
+  fprintf(fp, "Cycles=%lu, InFire=%lu, InStall=%lu, OutFire=%lu, "
+              "OutStall=%lu\n",
+          cycles, in_fires, in_stalls, out_fires, out_stalls);
+  fprintf(fp, "Throughput=%.4f results/cycle\n\n",
+          cycles ? (double)out_fires / cycles : 0.0);
+
+  fprintf(fp, "%-13s %10s %10s %10s %10s\n", "Stage", "Occupancy", "Stalled",
+          "Bubbles", "StallSrc");
+  fprintf(fp, "-----------------------------------------------------------\n");
+  for (int k = 0; k < num_active; k++) {
+    pipe_stage *s = active[k];
+    fprintf(fp, "%-13s %9.2f%% %10lu %10lu %10lu\n", s->name,
+            cycles ? s->occupied * 100.0 / cycles : 0.0, s->stalled,
+            s->bubbles, stall_origin_count[k]);
+  }
+
+  fprintf(fp, "\nStallSrc counts stage-cycles stalled because that stage's "
+              "consumer held ready low;\n");
+  fprintf(fp, "for the last stage the consumer is io_out_ready.\n");
+  fprintf(fp, "Bubble origins:");
+  for (int i = 0; i < ORIGIN_NUM; i++)
+    fprintf(fp, " %s=%lu", origin_name[i], bubble_origin_count[i]);
+  fprintf(fp, "\n");
+}
+
+void pipeprof_report(const char *report_file) {
+  if (num_active == 0)
+    return;
+  print_report(stdout);
+  if (report_file) {
+    FILE *fp = fopen(report_file, "w");
+    if (!fp) {
+      printf("Warning: Failed to save pipeline report.\n");
+      return;
+    }
+    print_report(fp);
+    fclose(fp);
+  }
+}
+
+void pipeprof_exit() {
+  if (trace_fp) {
+    fclose(trace_fp);
+    trace_fp = NULL;
+  }
+}
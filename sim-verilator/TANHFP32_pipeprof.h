@@ -0,0 +1,28 @@
+#ifndef __TANHFP32_PIPEPROF_H__
+#define __TANHFP32_PIPEPROF_H__
+
+#include <cstdint>
+#include <verilated.h>
+
+// Pipeline occupancy and bubble analyzer.
+//
+// Samples the rValid register of every handshakePipeIf stage once per cycle
+// through Verilator's public scope table, so the model must be verilated
+// with --public-flat-rw. The stages are found by walking every scope under
+// TOP.TANHFP32 for *Pipe_rValid, so whatever a configuration registers is
+// profiled, and put in datapath order. The ready chain is rebuilt from the valids and io_out_ready,
+// which is exact for these single-entry pipe registers.
+
+// Finds the stage registers, false if there are none or they cannot be
+// ordered; trace_file may be NULL
+bool pipeprof_init(VerilatedContext *contextp, const char *trace_file,
+                   uint64_t trace_cycles);
+
+// Call once per cycle before the rising edge, with this cycle's inputs
+void pipeprof_sample(bool in_valid, bool out_ready, bool draining);
+
+void pipeprof_report(const char *report_file);
+
+void pipeprof_exit();
+
+#endif
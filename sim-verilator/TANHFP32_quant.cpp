@@ -0,0 +1,265 @@
+// Exhaustive testbench for the quantized formats of TANHFP32. The RTL is
+// generated with --in-format/--out-format and this file is compiled with the
+// matching CONFIG_IN_FORMAT/CONFIG_OUT_FORMAT (TANH_FMT_*), see make quant.
+//
+// Fixed-point inputs are swept over every code, every inFrac and every
+// outFrac; FP32 inputs over a bit-pattern range for each outFrac. Every
+// result is compared bit-exactly with the model, and its distance to the
+// exact tanh is reported in units of the output LSB.
+
+#include "TANHFP32_harness.h"
+#include "TANHFP32_model.h"
+#include <VTANHFP32.h>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <getopt.h>
+
+#ifndef CONFIG_IN_FORMAT
+#define CONFIG_IN_FORMAT TANH_FMT_INT8
+#endif
+#ifndef CONFIG_OUT_FORMAT
+#define CONFIG_OUT_FORMAT TANH_FMT_INT8
+#endif
+
+#define IN_FIXED (CONFIG_IN_FORMAT == TANH_FMT_INT8 || CONFIG_IN_FORMAT == TANH_FMT_INT16)
+#define OUT_FIXED (CONFIG_OUT_FORMAT == TANH_FMT_INT8 || CONFIG_OUT_FORMAT == TANH_FMT_INT16)
+#define FRAC_MAX 15
+#define CHUNK (1 << 20)
+
+static const char *format_name[] = {"fp32", "bf16", "int8", "int16"};
+
+static tb_sim<VTANHFP32> sim;
+static tanh_model model;
+
+struct quant_txn {
+  uint32_t in;
+  uint8_t in_frac;
+  uint8_t out_frac;
+};
+
+struct quant_stats {
+  uint64_t n;
+  uint64_t mismatch;
+  uint64_t not_rounded;
+  double max_lsb;
+  double total_lsb;
+};
+
+static float bits_float(uint32_t u) {
+  float f;
+  memcpy(&f, &u, sizeof(f));
+  return f;
+}
+
+static void drive_dut(const quant_txn *txn, uint32_t *out, int n) {
+  VTANHFP32 *top = sim.top;
+  int issued = 0;
+  int received = 0;
+  top->io_out_ready = 1;
+
+  while (received < n) {
+    top->io_in_valid = issued < n;
+    if (issued < n) {
+      top->io_in_bits_in = txn[issued].in;
+      top->io_in_bits_rm = 0;
+#if IN_FIXED
+      top->io_in_bits_inFrac = txn[issued].in_frac;
+#endif
+#if OUT_FIXED
+      top->io_in_bits_outFrac = txn[issued].out_frac;
+#endif
+    }
+    bool in_fire = top->io_in_valid && top->io_in_ready;
+    bool out_fire = top->io_out_valid;
+    uint32_t out_bits = top->io_out_bits_out;
+    tb_sim_cycle(&sim);
+    if (in_fire)
+      issued++;
+    if (out_fire)
+      out[received++] = out_bits;
+  }
+}
+
+static uint32_t txn_fp32(const quant_txn *t) {
+#if IN_FIXED
+  int shift = 32 - tanh_format_width(CONFIG_IN_FORMAT);
+  return tanh_model_fixed_to_fp32((int32_t)(t->in << shift) >> shift,
+                                  t->in_frac);
+#else
+  return t->in;
+#endif
+}
+
+// Value of an output code, and the spacing of codes around the exact value t
+static double out_value(uint32_t out, int frac, double t, double *lsb) {
+  int e;
+  switch (CONFIG_OUT_FORMAT) {
+  case TANH_FMT_INT8:
+  case TANH_FMT_INT16: {
+    int shift = 32 - tanh_format_width(CONFIG_OUT_FORMAT);
+    *lsb = ldexp(1.0, -frac);
+    return ldexp((double)((int32_t)(out << shift) >> shift), -frac);
+  }
+  case TANH_FMT_BF16:
+    frexp(t, &e);
+    *lsb = ldexp(1.0, (e < -125 ? -125 : e) - 8);
+    return bits_float(out << 16);
+  default:
+    frexp(t, &e);
+    *lsb = ldexp(1.0, (e < -125 ? -125 : e) - 24);
+    return bits_float(out);
+  }
+}
+
+static void check(const quant_txn *txn, const uint32_t *dut, int n,
+                  quant_stats *stats) {
+  int width = tanh_format_width(CONFIG_OUT_FORMAT);
+  for (int i = 0; i < n; i++) {
+    uint32_t x = txn_fp32(&txn[i]);
+    uint32_t expect = tanh_model_convert_out(tanh_model_eval(&model, x),
+                                             CONFIG_OUT_FORMAT,
+                                             txn[i].out_frac);
+    stats->n++;
+    if (dut[i] != expect && stats->mismatch++ < 10)
+      printf("Model mismatch: in 0x%0*x inFrac %d outFrac %d dut 0x%0*x "
+             "model 0x%0*x\n",
+             tanh_format_width(CONFIG_IN_FORMAT) / 4, txn[i].in,
+             txn[i].in_frac, txn[i].out_frac, width / 4, dut[i], width / 4,
+             expect);
+
+    double xv = bits_float(x);
+    if (std::isnan(xv))
+      continue;
+    double t = tanh(xv), lsb;
+    double v = out_value(dut[i], txn[i].out_frac, t, &lsb);
+#if OUT_FIXED
+    // Saturation is the format's range, not an error
+    double max = ldexp(1.0, width - 1 - txn[i].out_frac);
+    t = t > max - lsb ? max - lsb : t < -max ? -max : t;
+#endif
+    double err = fabs(v - t) / lsb;
+    stats->total_lsb += err;
+    if (err > stats->max_lsb)
+      stats->max_lsb = err;
+    if (err > 0.5)
+      stats->not_rounded++;
+  }
+}
+
+static void usage(const char *prog) {
+  printf("Usage: %s [options]\n", prog);
+  printf("  --lut FILE          Coefficient file of the RTL (default: "
+         "lut.txt)\n");
+  printf("  --out-frac LO:HI    outFrac values, HI inclusive (default: all "
+         "for fixed-point\n"
+         "                      inputs, width-1 for FP32 inputs)\n");
+  printf("  --range LO:HI       FP32 input bit patterns, HI exclusive "
+         "(default: 0:0x100000000)\n");
+}
+
+int main(int argc, char **argv) {
+  const char *lut_file = "lut.txt";
+  int out_bits = tanh_format_width(CONFIG_OUT_FORMAT);
+  int frac_lo = 0, frac_hi = 0;
+  uint64_t lo = 0, hi = 1ull << 32;
+  char *end;
+
+  if (OUT_FIXED) {
+    frac_lo = IN_FIXED ? 0 : out_bits - 1;
+    frac_hi = out_bits - 1;
+  }
+
+  static struct option long_opts[] = {
+      {"lut", required_argument, NULL, 'l'},
+      {"out-frac", required_argument, NULL, 'o'},
+      {"range", required_argument, NULL, 'g'},
+      {"help", no_argument, NULL, 'h'},
+      {NULL, 0, NULL, 0}};
+  int opt;
+  while ((opt = getopt_long(argc, argv, "h", long_opts, NULL)) != -1) {
+    switch (opt) {
+    case 'l':
+      lut_file = optarg;
+      break;
+    case 'o':
+      frac_lo = strtol(optarg, &end, 0);
+      frac_hi = *end == ':' ? strtol(end + 1, NULL, 0) : frac_lo;
+      if (frac_lo < 0 || frac_hi > FRAC_MAX || frac_lo > frac_hi) {
+        printf("Error: Invalid outFrac range '%s'\n", optarg);
+        return 1;
+      }
+      break;
+    case 'g':
+      lo = strtoull(optarg, &end, 0);
+      hi = *end == ':' ? strtoull(end + 1, NULL, 0) : lo + 1;
+      if (hi > 1ull << 32 || lo >= hi) {
+        printf("Error: Invalid range '%s'\n", optarg);
+        return 1;
+      }
+      break;
+    default:
+      usage(argv[0]);
+      return opt == 'h' ? 0 : 1;
+    }
+  }
+  if (!OUT_FIXED)
+    frac_lo = frac_hi = 0;
+  tanh_model_init(&model);
+  if (!tanh_model_load_lut(&model, lut_file))
+    return 1;
+
+  // Sweep order: outFrac, then inFrac, then the input code
+  uint64_t codes, in_fracs = 1;
+  if (IN_FIXED) {
+    lo = 0;
+    codes = 1ull << tanh_format_width(CONFIG_IN_FORMAT);
+    in_fracs = FRAC_MAX + 1;
+  } else {
+    codes = hi - lo;
+  }
+  uint64_t total = codes * in_fracs * (frac_hi - frac_lo + 1);
+
+  printf("\n=== Quantized TANH Tests: %s in, %s out ===\n",
+         format_name[CONFIG_IN_FORMAT], format_name[CONFIG_OUT_FORMAT]);
+  printf("%lu codes x %lu inFrac x outFrac %d..%d = %lu transactions\n", codes,
+         in_fracs, frac_lo, frac_hi, total);
+
+  tb_sim_init(&sim, NULL);
+  tb_sim_reset(&sim, 10);
+  quant_txn *txn = (quant_txn *)malloc(sizeof(quant_txn) * CHUNK);
+  uint32_t *dut = (uint32_t *)malloc(sizeof(uint32_t) * CHUNK);
+  quant_stats stats;
+  memset(&stats, 0, sizeof(stats));
+
+  for (uint64_t base = 0; base < total; base += CHUNK) {
+    int n = total - base < (uint64_t)CHUNK ? (int)(total - base) : CHUNK;
+    for (int i = 0; i < n; i++) {
+      uint64_t k = base + i;
+      txn[i].in = (uint32_t)(lo + k % codes);
+      txn[i].in_frac = (uint8_t)(k / codes % in_fracs);
+      txn[i].out_frac = (uint8_t)(frac_lo + k / codes / in_fracs);
+    }
+    drive_dut(txn, dut, n);
+    check(txn, dut, n, &stats);
+    if ((base / CHUNK) % 256 == 255 || base + n >= total)
+      printf("  %5.1f%% done, max error %.3f LSB\n",
+             100.0 * (base + n) / total, stats.max_lsb);
+  }
+
+  printf("\nTransactions:        %lu\n", stats.n);
+  printf("Model mismatches:    %lu\n", stats.mismatch);
+  printf("Max error:           %.4f LSB\n", stats.max_lsb);
+  printf("Avg error:           %.4f LSB\n", stats.total_lsb / stats.n);
+  printf("Not correctly rounded: %lu (%.4f%%)\n", stats.not_rounded,
+         100.0 * stats.not_rounded / stats.n);
+  printf("Total cycles: %lu\n", sim.cycles);
+  printf("\n%s\n", stats.mismatch ? "FAILED" : "PASSED");
+
+  free(txn);
+  free(dut);
+  tb_sim_free(&sim);
+  return stats.mismatch ? 1 : 0;
+}
@@ -0,0 +1,71 @@
+#include "TANHFP32_ref.h"
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+float tanh_ref_glibc(float x) { return tanhf(x); }
+
+float tanh_ref_cr(float x) {
+  double y = tanh((double)x);
+  uint64_t u;
+  memcpy(&u, &y, sizeof(u));
+
+  // The double result is within an ulp of the exact value, so rounding it to
+  // float can only go wrong when it sits right next to a float midpoint. The
+  // 29 low bits are what the conversion drops; redo those cases wider.
+  uint32_t dropped = u & 0x1FFFFFFF;
+  if (dropped >= 0x0FFFFFFE && dropped <= 0x10000002)
+    return (float)tanhl((long double)x);
+  return (float)y;
+}
+
+// __expf(x) is ex2.approx(x * log2(e)); exp2f stands in for ex2.approx
+static float fast_expf(float x) { return exp2f(x * 1.4426950409f); }
+
+// __fdividef returns 0 when the divisor is huge instead of a subnormal
+static float fast_fdividef(float a, float b) {
+  if (fabsf(b) > 8.507059173e37f && fabsf(b) < INFINITY)
+    return 0.0f;
+  return a / b;
+}
+
+float tanh_ref_fastmath(float x) {
+  // -use_fast_math flushes subnormal inputs to zero
+  if (std::fpclassify(x) == FP_SUBNORMAL)
+    x = copysignf(0.0f, x);
+
+  float t = fabsf(x);
+  float s;
+  if (t >= 0.55f) {
+    s = 1.0f - fast_fdividef(2.0f, fast_expf(2.0f * t) + 1.0f);
+    if (t > 88.0f)
+      s = 1.0f;
+    s = copysignf(s, x);
+  } else {
+    float z2 = x * x;
+    t = 1.6211200013e-2f;
+    t = fmaf(t, z2, -5.4113730788e-2f);
+    t = fmaf(t, z2, 1.3350591064e-1f);
+    t = fmaf(t, z2, -3.3332946897e-1f);
+    t = t * z2;
+    s = fmaf(t, x, x);
+    if ((x + x) == 0.0f)
+      s = x + x;
+  }
+  return s;
+}
+
+void tanh_ref_glibc_batch(const float *vin, float *vout, int n) {
+  for (int i = 0; i < n; i++)
+    vout[i] = tanhf(vin[i]);
+}
+
+void tanh_ref_cr_batch(const float *vin, float *vout, int n) {
+  for (int i = 0; i < n; i++)
+    vout[i] = tanh_ref_cr(vin[i]);
+}
+
+void tanh_ref_fastmath_batch(const float *vin, float *vout, int n) {
+  for (int i = 0; i < n; i++)
+    vout[i] = tanh_ref_fastmath(vin[i]);
+}
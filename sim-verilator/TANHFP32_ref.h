@@ -0,0 +1,20 @@
+#ifndef __TANHFP32_REF_H__
+#define __TANHFP32_REF_H__
+
+// Software tanh references, one value and batched.
+//
+// glibc:    tanhf from the C library, as used by the testbench so far
+// cr:       correctly rounded (RNE) tanh
+// fastmath: host emulation of the CUDA -use_fast_math tanhf formula
+//           (__expf/__fdividef path); it follows the formula, not the exact
+//           bits of a particular GPU's SFU
+
+float tanh_ref_glibc(float x);
+float tanh_ref_cr(float x);
+float tanh_ref_fastmath(float x);
+
+void tanh_ref_glibc_batch(const float *vin, float *vout, int n);
+void tanh_ref_cr_batch(const float *vin, float *vout, int n);
+void tanh_ref_fastmath_batch(const float *vin, float *vout, int n);
+
+#endif
@@ -0,0 +1,197 @@
+#include "TANHFP32_refset.h"
+#include "TANHFP32_model.h"
+#include "TANHFP32_ref.h"
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+
+// Below this many vectors per thread the spawn costs more than it saves
+#define MIN_SLICE 4096
+
+#ifdef __USE_GPU_REF__
+extern "C" void tanh_nvidia_batch(float *vin, float *golden, int n);
+
+static void tanh_gpu_batch(const float *vin, float *vout, int n) {
+  tanh_nvidia_batch((float *)vin, vout, n);
+}
+#endif
+
+static const ref_provider providers[] = {
+    {"glibc", "CPU_Ref", tanh_ref_glibc_batch, NULL, false},
+    {"cr", "CR_Ref", tanh_ref_cr_batch, NULL, false},
+    {"fastmath", "FastMath_Ref", tanh_ref_fastmath_batch, NULL, false},
+    {"model", "Model_Ref", NULL, tanh_model_batch, false},
+#ifdef __USE_GPU_REF__
+    {"gpu", "GPU_Ref", tanh_gpu_batch, NULL, true},
+#endif
+};
+#define NUM_PROVIDERS (int)(sizeof(providers) / sizeof(providers[0]))
+
+#ifdef __USE_GPU_REF__
+const char *ref_default_names = "glibc,gpu";
+#else
+const char *ref_default_names = "glibc";
+#endif
+
+void ref_list_providers() {
+  for (int i = 0; i < NUM_PROVIDERS; i++)
+    printf("%s%s", i ? ", " : "", providers[i].name);
+}
+
+int ref_parse(const char *names, const ref_provider **list) {
+  char buf[256];
+  int n = 0;
+  snprintf(buf, sizeof(buf), "%s", names);
+  for (char *tok = strtok(buf, ","); tok; tok = strtok(NULL, ",")) {
+    int i = 0;
+    while (i < NUM_PROVIDERS && strcmp(tok, providers[i].name))
+      i++;
+    if (i == NUM_PROVIDERS) {
+      printf("Error: Unknown reference '%s' (available: ", tok);
+      ref_list_providers();
+      printf(")\n");
+      return -1;
+    }
+    if (n == REF_SET_MAX) {
+      printf("Error: At most %d references\n", REF_SET_MAX);
+      return -1;
+    }
+    list[n++] = &providers[i];
+  }
+  if (n == 0)
+    printf("Error: No reference selected\n");
+  return n ? n : -1;
+}
+
+void ref_set_init(ref_set *set, const ref_provider *const *list, int n,
+                  int cap, int threads, const tanh_model *model) {
+  memset(set, 0, sizeof(*set));
+  set->n = n;
+  set->cap = cap;
+  set->model = model;
+  if (threads <= 0)
+    threads = (int)std::thread::hardware_concurrency();
+  set->threads = threads > 0 ? threads : 1;
+  for (int r = 0; r < n; r++) {
+    set->provider[r] = list[r];
+    set->out[r] = (float *)malloc(sizeof(float) * cap);
+  }
+}
+
+void ref_set_free(ref_set *set) {
+  for (int r = 0; r < set->n; r++)
+    free(set->out[r]);
+  set->n = 0;
+}
+
+// One slice of the fused pass: the parallel references of [lo, hi), then the
+// statistics of every reference while the slice is still in cache
+static void check_slice(ref_set *set, const float *vin, const float *dut,
+                        int lo, int hi, double err_threshold,
+                        uint64_t ulp_threshold, bool with_stats,
+                        error_stats *stats) {
+  for (int r = 0; r < set->n; r++) {
+    const ref_provider *p = set->provider[r];
+    if (p->model_batch)
+      p->model_batch(set->model, vin + lo, set->out[r] + lo, hi - lo);
+    else if (!p->serial)
+      p->batch(vin + lo, set->out[r] + lo, hi - lo);
+  }
+  if (!with_stats)
+    return;
+  for (int r = 0; r < set->n; r++)
+    error_stats_update(&stats[r], vin + lo, dut + lo, set->out[r] + lo,
+                       hi - lo, err_threshold, ulp_threshold, false);
+}
+
+void ref_set_check(ref_set *set, const float *vin, const float *dut, int n,
+                   double err_threshold, uint64_t ulp_threshold,
+                   bool print_failures) {
+  for (int r = 0; r < set->n; r++) {
+    if (set->provider[r]->serial)
+      set->provider[r]->batch(vin, set->out[r], n);
+  }
+
+  int threads = n / MIN_SLICE < set->threads ? n / MIN_SLICE : set->threads;
+  if (threads < 1)
+    threads = 1;
+  // Per-thread partial statistics, merged after the join
+  error_stats(*stats)[REF_SET_MAX] =
+      (error_stats(*)[REF_SET_MAX])calloc(threads, sizeof(*stats));
+  std::thread *workers = threads > 1 ? new std::thread[threads - 1] : NULL;
+  for (int t = 0; t < threads; t++) {
+    int lo = (int)((int64_t)n * t / threads);
+    int hi = (int)((int64_t)n * (t + 1) / threads);
+    if (t == threads - 1)
+      check_slice(set, vin, dut, lo, hi, err_threshold, ulp_threshold,
+                  !print_failures, stats[t]);
+    else
+      workers[t] = std::thread(check_slice, set, vin, dut, lo, hi,
+                               err_threshold, ulp_threshold, !print_failures,
+                               stats[t]);
+  }
+  for (int t = 0; t < threads - 1; t++)
+    workers[t].join();
+  delete[] workers;
+
+  if (print_failures) {
+    for (int r = 0; r < set->n; r++)
+      error_stats_update(&set->stats[r], vin, dut, set->out[r], n,
+                         err_threshold, ulp_threshold, r == 0);
+  } else {
+    for (int t = 0; t < threads; t++)
+      for (int r = 0; r < set->n; r++)
+        error_stats_merge(&set->stats[r], &stats[t][r]);
+  }
+  free(stats);
+}
+
+void ref_set_print(const ref_set *set) {
+  for (int r = 0; r < set->n; r++)
+    error_stats_print(&set->stats[r], set->provider[r]->label);
+}
+
+static void save_rows(const ref_set *set, FILE *fp, const float *vin,
+                      const float *dut, int n) {
+  for (int i = 0; i < n; i++) {
+    fprintf(fp, "%.9e,%.9e", vin[i], dut[i]);
+    for (int r = 0; r < set->n; r++)
+      fprintf(fp, ",%.9e", set->out[r][i]);
+    fprintf(fp, "\n");
+  }
+}
+
+void ref_set_save_csv(const ref_set *set, const char *filename,
+                      const float *vin, const float *dut, int n) {
+  printf("Saving data to %s...\n", filename);
+  FILE *fp = fopen(filename, "w");
+  if (!fp) {
+    printf("Warning: Failed to save data file.\n");
+    return;
+  }
+
+  fprintf(fp, "in,dut");
+  for (int r = 0; r < set->n; r++) {
+    fprintf(fp, ",");
+    for (const char *c = set->provider[r]->label; *c; c++)
+      fputc(tolower(*c), fp);
+  }
+  fprintf(fp, "\n");
+  save_rows(set, fp, vin, dut, n);
+
+  fclose(fp);
+  printf("Data saved successfully.\n");
+}
+
+void ref_set_append_csv(const ref_set *set, const char *filename,
+                        const float *vin, const float *dut, int n) {
+  FILE *fp = fopen(filename, "a");
+  if (!fp) {
+    printf("Warning: Failed to append to data file.\n");
+    return;
+  }
+  save_rows(set, fp, vin, dut, n);
+  fclose(fp);
+}
@@ -0,0 +1,72 @@
+#ifndef __TANHFP32_REFSET_H__
+#define __TANHFP32_REFSET_H__
+
+#include "TANHFP32_stats.h"
+
+struct tanh_model;
+
+// Runtime-selected set of tanh references the DUT is checked against.
+//
+// Every provider is a batched function. Parallel ones must be safe to call
+// from several threads on disjoint slices; serial ones (the CUDA SFU, which
+// owns the device) run over the whole chunk on the calling thread first.
+// ref_set_check then computes the parallel references and updates the
+// statistics of every provider in one pass, split across threads. The model
+// reference evaluates the tanh_model the set was given, so sets checking
+// different DUT variants can run side by side.
+
+#define REF_SET_MAX 8
+
+struct ref_provider {
+  const char *name;  // --ref name
+  const char *label; // statistics heading; lower-cased, the CSV column
+  void (*batch)(const float *vin, float *vout, int n);
+  // In place of batch, for references computed by the set's model
+  void (*model_batch)(const tanh_model *m, const float *vin, float *vout,
+                      int n);
+  bool serial;
+};
+
+struct ref_set {
+  int n;
+  const ref_provider *provider[REF_SET_MAX];
+  float *out[REF_SET_MAX]; // references of the last chunk; out[0] is primary
+  error_stats stats[REF_SET_MAX];
+  int cap;
+  int threads;
+  const tanh_model *model; // loaded, for providers with a model_batch
+};
+
+// glibc, plus the GPU when the CUDA object is linked in
+extern const char *ref_default_names;
+
+void ref_list_providers();
+
+// Comma-separated names into list; number of providers, or -1 on error
+int ref_parse(const char *names, const ref_provider **list);
+
+// Buffers for chunks of up to cap vectors; threads <= 0 uses every core.
+// model may be NULL when no provider has a model_batch.
+void ref_set_init(ref_set *set, const ref_provider *const *list, int n,
+                  int cap, int threads, const tanh_model *model);
+
+void ref_set_free(ref_set *set);
+
+// Failures are printed against the primary reference only. Printing is
+// serial, so it turns the statistics part of the pass single-threaded.
+void ref_set_check(ref_set *set, const float *vin, const float *dut, int n,
+                   double err_threshold, uint64_t ulp_threshold,
+                   bool print_failures);
+
+void ref_set_print(const ref_set *set);
+
+// Writes in,dut and one column per reference for the last chunk
+void ref_set_save_csv(const ref_set *set, const char *filename,
+                      const float *vin, const float *dut, int n);
+
+// Adds the rows of another set's last chunk to a file ref_set_save_csv
+// started; the sets must have the same providers
+void ref_set_append_csv(const ref_set *set, const char *filename,
+                        const float *vin, const float *dut, int n);
+
+#endif
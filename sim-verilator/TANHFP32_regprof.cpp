@@ -0,0 +1,265 @@
+#include "TANHFP32_regprof.h"
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <verilated_syms.h>
+
+#define TOP_SCOPE "TOP.TANHFP32"
+#define REG_MARK "Pipe_rBits_"
+// Widest pipeline register is the 74-bit multiplier significand
+#define MAX_WORDS 4
+// Fields up to this width also record which values occurred
+#define VALUE_BITS 16
+
+struct pipe_reg {
+  // Instance path below the top ("top" for the top itself), stage, and
+  // bundle field, whose nesting levels firtool joins with '_'
+  char inst[64];
+  char stage[16];
+  char field[96];
+  int width;
+  int vltype;
+  const void *datap;
+  const uint8_t *valid;
+  uint64_t samples;
+  uint32_t prev[MAX_WORDS];
+  uint32_t ever0[MAX_WORDS];
+  uint32_t ever1[MAX_WORDS];
+  uint32_t toggled[MAX_WORDS];
+  uint64_t *values;
+};
+
+static pipe_reg *regs = NULL;
+static int num_regs = 0;
+static uint64_t cycles = 0;
+
+static int words(int width) { return (width + 31) / 32; }
+
+static uint32_t word_mask(int width, int w) {
+  int bits = width - 32 * w;
+  return bits >= 32 ? 0xFFFFFFFFu : (1u << bits) - 1;
+}
+
+static void read_reg(const pipe_reg *r, uint32_t *v) {
+  memset(v, 0, sizeof(uint32_t) * MAX_WORDS);
+  switch (r->vltype) {
+  case VLVT_UINT8:
+    v[0] = *(const uint8_t *)r->datap;
+    break;
+  case VLVT_UINT16:
+    v[0] = *(const uint16_t *)r->datap;
+    break;
+  case VLVT_UINT32:
+    v[0] = *(const uint32_t *)r->datap;
+    break;
+  case VLVT_UINT64: {
+    uint64_t q = *(const uint64_t *)r->datap;
+    v[0] = (uint32_t)q;
+    v[1] = (uint32_t)(q >> 32);
+    break;
+  }
+  default:
+    memcpy(v, r->datap, sizeof(uint32_t) * words(r->width));
+    break;
+  }
+  for (int w = 0; w < words(r->width); w++)
+    v[w] &= word_mask(r->width, w);
+}
+
+static int reg_cmp(const void *a, const void *b) {
+  const pipe_reg *x = (const pipe_reg *)a, *y = (const pipe_reg *)b;
+  int c = strcmp(x->inst, y->inst);
+  if (c == 0)
+    c = strcmp(x->stage, y->stage);
+  return c;
+}
+
+bool regprof_init(VerilatedContext *contextp) {
+  const VerilatedScopeNameMap *scopes = contextp->scopeNameMap();
+  int cap = 0;
+  for (const auto &s : *scopes) {
+    const char *scope = s.first;
+    const VerilatedScope *scopep = s.second;
+    if (strncmp(scope, TOP_SCOPE, strlen(TOP_SCOPE)) || !scopep->varsp())
+      continue;
+    for (auto &v : *scopep->varsp()) {
+      const char *name = v.first;
+      const VerilatedVar &var = v.second;
+      const char *mark = strstr(name, REG_MARK);
+      if (!mark || var.udims() > 0 || var.packed().elements() > 32 * MAX_WORDS)
+        continue;
+
+      char valid_name[64];
+      snprintf(valid_name, sizeof(valid_name), "%.*sPipe_rValid",
+               (int)(mark - name), name);
+      const VerilatedVar *validp = scopep->varFind(valid_name);
+      if (!validp)
+        continue;
+
+      if (num_regs == cap) {
+        cap = cap ? 2 * cap : 64;
+        regs = (pipe_reg *)realloc(regs, sizeof(pipe_reg) * cap);
+      }
+      pipe_reg *r = &regs[num_regs++];
+      memset(r, 0, sizeof(*r));
+      const char *inst = scope + strlen(TOP_SCOPE);
+      snprintf(r->inst, sizeof(r->inst), "%s",
+               *inst == '.' ? inst + 1 : "top");
+      snprintf(r->stage, sizeof(r->stage), "%.*s", (int)(mark - name), name);
+      snprintf(r->field, sizeof(r->field), "%s", mark + strlen(REG_MARK));
+      r->width = var.packed().elements();
+      r->vltype = var.vltype();
+      r->datap = var.datap();
+      r->valid = (const uint8_t *)validp->datap();
+      if (r->width <= VALUE_BITS)
+        r->values = (uint64_t *)calloc(((1 << r->width) + 63) / 64,
+                                       sizeof(uint64_t));
+    }
+  }
+  if (num_regs == 0) {
+    printf("Warning: No pipeline registers found; was the model verilated "
+           "with --public-flat-rw?\n");
+    return false;
+  }
+  // Scope order is alphabetical; keep each stage's fields together
+  qsort(regs, num_regs, sizeof(pipe_reg), reg_cmp);
+  printf("Register profile: %d pipeline data registers\n", num_regs);
+  return true;
+}
+
+void regprof_sample() {
+  uint32_t v[MAX_WORDS];
+  for (int i = 0; i < num_regs; i++) {
+    pipe_reg *r = &regs[i];
+    if (!(*r->valid & 1))
+      continue;
+    read_reg(r, v);
+    for (int w = 0; w < words(r->width); w++) {
+      if (r->samples)
+        r->toggled[w] |= v[w] ^ r->prev[w];
+      r->ever1[w] |= v[w];
+      r->ever0[w] |= ~v[w] & word_mask(r->width, w);
+      r->prev[w] = v[w];
+    }
+    if (r->values)
+      r->values[v[0] / 64] |= 1ull << (v[0] % 64);
+    r->samples++;
+  }
+  cycles++;
+}
+
+static bool bit_set(const uint32_t *m, int b) {
+  return (m[b / 32] >> (b % 32)) & 1;
+}
+
+// Bits of mask m as "31,22:16", MSB first; "-" when empty
+static void format_bits(const uint32_t *m, int width, char *buf, size_t size) {
+  size_t len = 0;
+  buf[0] = '\0';
+  for (int hi = width - 1; hi >= 0; hi--) {
+    if (!bit_set(m, hi))
+      continue;
+    int lo = hi;
+    while (lo > 0 && bit_set(m, lo - 1))
+      lo--;
+    const char *sep = len ? "," : "";
+    if (len < size && hi == lo)
+      len += snprintf(buf + len, size - len, "%s%d", sep, hi);
+    else if (len < size)
+      len += snprintf(buf + len, size - len, "%s%d:%d", sep, hi, lo);
+    hi = lo;
+  }
+  if (!len)
+    snprintf(buf, size, "-");
+}
+
+static void print_report(FILE *fp) {
+  uint64_t total = 0, constant = 0, dead = 0, narrow = 0;
+  char const0[128], const1[128], field[192];
+
+  fprintf(fp, "\n=== Pipeline Register Bits ===\n");
+  fprintf(fp, "Cycles=%lu; samples are cycles in which the register's stage "
+              "held a valid transaction\n\n",
+          cycles);
+  fprintf(fp, "%-44s %5s %10s %7s %8s  %-20s %s\n", "Register", "Width",
+          "Samples", "Values", "Toggled", "Const 0", "Const 1");
+  fprintf(fp, "------------------------------------------------------------"
+              "--------------------------------------------------\n");
+  for (int i = 0; i < num_regs; i++) {
+    pipe_reg *r = &regs[i];
+    uint32_t c0[MAX_WORDS], c1[MAX_WORDS];
+    int toggled = 0, fixed = 0;
+    for (int b = 0; b < r->width; b++)
+      toggled += bit_set(r->toggled, b);
+    for (int w = 0; w < MAX_WORDS; w++) {
+      c0[w] = r->ever0[w] & ~r->ever1[w];
+      c1[w] = r->ever1[w] & ~r->ever0[w];
+    }
+    for (int b = 0; b < r->width; b++)
+      fixed += bit_set(c0, b) || bit_set(c1, b);
+
+    char values[16] = "-";
+    int distinct = 0;
+    if (r->values) {
+      for (int k = 0; k < ((1 << r->width) + 63) / 64; k++)
+        distinct += __builtin_popcountll(r->values[k]);
+      snprintf(values, sizeof(values), "%d", distinct);
+    }
+    snprintf(field, sizeof(field), "%s.%s.%s", r->inst, r->stage, r->field);
+
+    total += r->width;
+    if (r->samples == 0) {
+      dead += r->width;
+      fprintf(fp, "%-44s %5d %10s %7s %8s  never valid\n", field, r->width,
+              "0", "-", "-");
+      continue;
+    }
+    format_bits(c0, r->width, const0, sizeof(const0));
+    format_bits(c1, r->width, const1, sizeof(const1));
+    fprintf(fp, "%-44s %5d %10lu %7s %4d/%-3d  %-20s %s\n", field, r->width,
+            r->samples, values, toggled, r->width, const0, const1);
+    constant += fixed;
+    // Fewer distinct values than the width encodes, beyond the constant bits
+    if (distinct > 0) {
+      int need = 0;
+      while ((1 << need) < distinct)
+        need++;
+      if (need < r->width - fixed)
+        narrow += r->width - fixed - need;
+    }
+  }
+
+  fprintf(fp, "\nData flops: %lu, never valid: %lu, constant while valid: "
+              "%lu (%.1f%%)\n",
+          total, dead, constant,
+          total ? 100.0 * (dead + constant) / total : 0.0);
+  fprintf(fp, "Narrow fields could drop %lu more flops by re-encoding their "
+              "values (Values column)\n",
+          narrow);
+  fprintf(fp, "Bits are constant for the traffic of this run only; confirm "
+              "with --exhaustive\nbefore taking them out of the generator.\n");
+}
+
+void regprof_report(const char *report_file) {
+  if (num_regs == 0)
+    return;
+  print_report(stdout);
+  if (report_file) {
+    FILE *fp = fopen(report_file, "w");
+    if (!fp) {
+      printf("Warning: Failed to save register report.\n");
+      return;
+    }
+    print_report(fp);
+    fclose(fp);
+  }
+}
+
+void regprof_exit() {
+  for (int i = 0; i < num_regs; i++)
+    free(regs[i].values);
+  free(regs);
+  regs = NULL;
+  num_regs = 0;
+}
@@ -0,0 +1,25 @@
+#ifndef __TANHFP32_REGPROF_H__
+#define __TANHFP32_REGPROF_H__
+
+#include <verilated.h>
+
+// Constant-bit and dead-register analysis of the pipeline registers.
+//
+// Finds every handshakePipeIf data register (<stage>Pipe_rBits_<field>)
+// through Verilator's public scope table, so the model must be verilated
+// with --public-flat-rw. Each cycle that a register's stage holds a valid
+// transaction, it records per bit whether the bit was ever 0, ever 1 and
+// ever toggled between transactions, and for narrow fields which values
+// occurred. Bits that never change are flops the generator need not emit.
+
+// Looks up the registers of every stage the configuration has
+bool regprof_init(VerilatedContext *contextp);
+
+// Call once per cycle before the rising edge
+void regprof_sample();
+
+void regprof_report(const char *report_file);
+
+void regprof_exit();
+
+#endif
@@ -0,0 +1,196 @@
+#include "TANHFP32_seq.h"
+#include "TANHFP32_model.h"
+#include "TANHFP32_stats.h"
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#define SEQ_SEGMENTS TANH_INPUT_CLASSES
+// ULP histogram: exact up to SEQ_ULP_BINS - 2, the last bin is the overflow
+#define SEQ_ULP_BINS 4096
+
+struct seq_segment {
+  error_stats stats;
+  uint32_t ulp_hist[SEQ_ULP_BINS];
+  // Intervals from the last seq_converged
+  double pass_lo, pass_hi;
+  int64_t q_lo, q_hi;
+  bool converged;
+};
+
+struct seq_state {
+  seq_config config;
+  double z;
+  seq_segment segments[SEQ_SEGMENTS];
+  uint64_t total;
+  uint64_t batches;
+};
+
+// Two-sided standard normal quantile, by bisection on erf
+static double normal_z(double confidence) {
+  double lo = 0.0, hi = 10.0;
+  for (int i = 0; i < 100; i++) {
+    double mid = (lo + hi) / 2;
+    if (erf(mid / sqrt(2.0)) < confidence)
+      lo = mid;
+    else
+      hi = mid;
+  }
+  return (lo + hi) / 2;
+}
+
+seq_state *seq_alloc(const seq_config *cfg) {
+  seq_state *s = (seq_state *)calloc(1, sizeof(seq_state));
+  s->config = *cfg;
+  s->z = normal_z(cfg->confidence);
+  return s;
+}
+
+void seq_free(seq_state *s) { free(s); }
+
+void seq_update(seq_state *s, const float *vin, const float *dut,
+                const float *ref, int n, double err_threshold,
+                uint64_t ulp_threshold) {
+  for (int i = 0; i < n; i++) {
+    uint32_t x;
+    memcpy(&x, &vin[i], sizeof(x));
+    seq_segment *seg = &s->segments[tanh_input_class(x)];
+    error_stats_update(&seg->stats, &vin[i], &dut[i], &ref[i], 1,
+                       err_threshold, ulp_threshold, false);
+    uint64_t ulp = compute_ulp(ref[i], dut[i]);
+    seg->ulp_hist[ulp < SEQ_ULP_BINS - 1 ? ulp : SEQ_ULP_BINS - 1]++;
+  }
+  s->total += n;
+  s->batches++;
+}
+
+void seq_merge(seq_state *dst, seq_state *src) {
+  for (int seg = 0; seg < SEQ_SEGMENTS; seg++) {
+    seq_segment *d = &dst->segments[seg];
+    seq_segment *s = &src->segments[seg];
+    error_stats_merge(&d->stats, &s->stats);
+    for (int b = 0; b < SEQ_ULP_BINS; b++)
+      d->ulp_hist[b] += s->ulp_hist[b];
+  }
+  dst->total += src->total;
+  dst->batches += src->batches;
+  memset(src->segments, 0, sizeof(src->segments));
+  src->total = 0;
+  src->batches = 0;
+}
+
+// ULP of the k-th smallest error (1-based) of a segment
+static int64_t order_stat(const seq_segment *s, uint64_t k) {
+  uint64_t seen = 0;
+  for (int b = 0; b < SEQ_ULP_BINS; b++) {
+    seen += s->ulp_hist[b];
+    if (seen >= k)
+      return b;
+  }
+  return SEQ_ULP_BINS - 1;
+}
+
+static void update_intervals(const seq_state *st, seq_segment *s) {
+  double z = st->z;
+  double n = (double)s->stats.n;
+  double p = s->stats.pass / n;
+
+  // Wilson score interval; stays inside [0, 1] and is usable at p = 1
+  double centre = (p + z * z / (2 * n)) / (1 + z * z / n);
+  double half = z * sqrt(p * (1 - p) / n + z * z / (4 * n * n)) / (1 + z * z / n);
+  s->pass_lo = centre - half;
+  s->pass_hi = centre + half;
+
+  // Ranks whose order statistics bracket the q-quantile (normal
+  // approximation to the binomial); unbounded until n is large enough
+  double q = st->config.quantile;
+  double spread = z * sqrt(n * q * (1 - q));
+  int64_t lo = (int64_t)floor(n * q - spread);
+  int64_t hi = (int64_t)ceil(n * q + spread) + 1;
+  s->q_lo = lo >= 1 ? order_stat(s, lo) : -1;
+  s->q_hi = hi <= (int64_t)n ? order_stat(s, hi) : -1;
+
+  s->converged = half <= st->config.pass_tol && s->q_lo >= 0 &&
+                 s->q_hi >= 0 &&
+                 (uint64_t)(s->q_hi - s->q_lo) <= st->config.ulp_tol;
+}
+
+static bool rare(const seq_state *st, const seq_segment *s) {
+  return s->stats.n < SEQ_MIN_SHARE * st->total;
+}
+
+bool seq_converged(seq_state *st) {
+  bool done = st->total > 0;
+  for (int seg = 0; seg < SEQ_SEGMENTS; seg++) {
+    seq_segment *s = &st->segments[seg];
+    if (s->stats.n == 0)
+      continue;
+    update_intervals(st, s);
+    done &= s->converged || rare(st, s);
+  }
+  return done;
+}
+
+static void print_segment(const seq_state *st, FILE *fp, int seg) {
+  const seq_segment *s = &st->segments[seg];
+  char name[16], q_lo[16], q_hi[16];
+  tanh_input_class_name(seg, name, sizeof(name));
+  snprintf(q_lo, sizeof(q_lo), s->q_lo >= 0 ? "%ld" : "-", s->q_lo);
+  snprintf(q_hi, sizeof(q_hi), s->q_hi >= 0 ? "%ld" : "-", s->q_hi);
+  fprintf(fp, "%-10s %10lu %8.4f [%6.4f, %6.4f] %6s %6s  %s\n", name,
+          s->stats.n, (double)s->stats.pass / s->stats.n, s->pass_lo,
+          s->pass_hi, q_lo, q_hi,
+          s->converged ? "yes" : rare(st, s) ? "rare" : "no");
+}
+
+static void print_report(const seq_state *st, FILE *fp, bool all) {
+  fprintf(fp, "\n%-10s %10s %8s %18s %13s  %s\n", "Segment", "Vectors",
+          "Pass", "Pass interval", "ULP q-interval", "Converged");
+  fprintf(fp, "---------------------------------------------------------------"
+              "-------------------\n");
+  int hidden = 0;
+  for (int seg = 0; seg < SEQ_SEGMENTS; seg++) {
+    const seq_segment *s = &st->segments[seg];
+    if (s->stats.n == 0)
+      continue;
+    if (all || !s->converged)
+      print_segment(st, fp, seg);
+    else
+      hidden++;
+  }
+  if (hidden)
+    fprintf(fp, "... %d converged segments, see the report file\n", hidden);
+}
+
+void seq_report(seq_state *s, uint64_t fixed_n, const char *report_file) {
+  const seq_config *cfg = &s->config;
+  uint64_t total = s->total;
+  bool done = seq_converged(s);
+  printf("\n=== Sequential Stopping ===\n");
+  printf("Confidence %.3f, pass-rate half-width <= %g, q%g ULP interval <= "
+         "%lu\n",
+         cfg->confidence, cfg->pass_tol, cfg->quantile * 100,
+         cfg->ulp_tol);
+  printf("%s after %lu vectors in %lu batches\n",
+         done ? "Converged" : "Budget exhausted", total, s->batches);
+  if (total < fixed_n)
+    printf("Saved %lu of the fixed %lu-vector run (%.1f%%)\n",
+           fixed_n - total, fixed_n, 100.0 * (fixed_n - total) / fixed_n);
+  else
+    printf("No saving against the fixed %lu-vector run\n", fixed_n);
+  print_report(s, stdout, report_file == NULL);
+
+  if (report_file) {
+    FILE *fp = fopen(report_file, "w");
+    if (!fp) {
+      printf("Warning: Failed to save sequential report.\n");
+      return;
+    }
+    fprintf(fp, "=== Sequential Stopping ===\n");
+    fprintf(fp, "%s after %lu vectors, fixed run %lu\n",
+            done ? "Converged" : "Budget exhausted", total, fixed_n);
+    print_report(s, fp, true);
+    fclose(fp);
+  }
+}
@@ -0,0 +1,47 @@
+#ifndef __TANHFP32_SEQ_H__
+#define __TANHFP32_SEQ_H__
+
+#include <cstdint>
+
+// Sequential stopping rule for random campaigns.
+//
+// Vectors are binned by segment: one of the 64 LUT regions or one of the
+// filter's bypass reasons, as in the coverage model. After each batch, every
+// segment gets two intervals at the requested confidence:
+//   - the Wilson score interval of its pass rate
+//   - the order-statistic interval of a tail quantile of its ULP error
+// The campaign has converged once both are within tolerance in every
+// segment that holds at least SEQ_MIN_SHARE of the vectors. Rarer segments
+// are reported but do not hold up the stop.
+//
+// Parallel environments each update their own seq_state and merge it into
+// the campaign's between batches.
+
+#define SEQ_MIN_SHARE 1e-4
+
+struct seq_config {
+  double confidence; // two-sided, e.g. 0.95
+  double pass_tol;   // max half-width of a pass-rate interval
+  double quantile;   // ULP quantile, e.g. 0.99
+  uint64_t ulp_tol;  // max width of a quantile interval, in ULP
+};
+
+struct seq_state;
+
+seq_state *seq_alloc(const seq_config *cfg);
+void seq_free(seq_state *s);
+
+// Same pass criterion as error_stats_update
+void seq_update(seq_state *s, const float *vin, const float *dut,
+                const float *ref, int n, double err_threshold,
+                uint64_t ulp_threshold);
+
+// Adds the vectors of src into dst, then empties src
+void seq_merge(seq_state *dst, seq_state *src);
+
+bool seq_converged(seq_state *s);
+
+// fixed_n is the size of the fixed-N run the campaign replaces
+void seq_report(seq_state *s, uint64_t fixed_n, const char *report_file);
+
+#endif
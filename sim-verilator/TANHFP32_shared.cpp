@@ -0,0 +1,366 @@
+// Testbench for TANHFP32Shared: PORTS requesters share one core through the
+// weighted round-robin arbiter. Each port has its own offered load and its
+// own consumer readiness. Every result is checked bit-exactly against the
+// model and against its port's request order, so a lost, duplicated,
+// reordered or misrouted response shows up as a mismatch. The report covers
+// per-port throughput against the weighted max-min fair share, the Jain
+// fairness index over those shares, and arbitration and total latency. A
+// port with demand that falls clearly below its share, or a Jain index
+// below JAIN_MIN, fails the test.
+
+#include "TANHFP32_harness.h"
+#include "TANHFP32_model.h"
+#include <VTANHFP32Shared.h>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <getopt.h>
+
+#ifndef CONFIG_SHARED_PORTS
+#define CONFIG_SHARED_PORTS 4
+#endif
+#define PORTS CONFIG_SHARED_PORTS
+
+#if PORTS != 2 && PORTS != 4
+#error "CONFIG_SHARED_PORTS must be 2 or 4"
+#endif
+
+// A port may fall short of its fair share by this fraction (sampling noise
+// of the random loads); the Jain index must stay above JAIN_MIN
+#define FAIR_TOL 0.05
+#define JAIN_MIN 0.98
+
+static tb_sim<VTANHFP32Shared> sim;
+static VTANHFP32Shared *top = NULL;
+static tanh_model model;
+
+struct port_io {
+  uint8_t *in_valid;
+  uint8_t *in_ready;
+  uint32_t *in_bits;
+  uint8_t *in_rm;
+  uint8_t *out_valid;
+  uint8_t *out_ready;
+  uint32_t *out_bits;
+};
+static port_io port[PORTS];
+
+#define BIND_PORT(i)                                                           \
+  port[i].in_valid = &top->io_in_##i##_valid;                                  \
+  port[i].in_ready = &top->io_in_##i##_ready;                                  \
+  port[i].in_bits = &top->io_in_##i##_bits_in;                                 \
+  port[i].in_rm = &top->io_in_##i##_bits_rm;                                   \
+  port[i].out_valid = &top->io_out_##i##_valid;                                \
+  port[i].out_ready = &top->io_out_##i##_ready;                                \
+  port[i].out_bits = &top->io_out_##i##_bits;
+
+static void bind_ports() {
+  BIND_PORT(0)
+  BIND_PORT(1)
+#if PORTS > 2
+  BIND_PORT(2)
+  BIND_PORT(3)
+#endif
+}
+
+static void sim_init() {
+  tb_sim_init(&sim, NULL);
+  top = sim.top;
+  bind_ports();
+  tb_sim_reset(&sim, 10);
+  // Traffic cycles count from the end of reset
+  sim.cycles = 0;
+}
+
+// A request from presentation until its result is accepted
+struct request {
+  uint32_t in;
+  uint64_t req_cycle;
+  uint64_t grant_cycle;
+};
+
+// Per-port requester and consumer
+struct port_state {
+  double load;  // probability of a new request arriving each cycle
+  double ready; // probability of accepting a result
+  int weight;
+  // Arrived requests wait in backlog, the oldest is presented on the port.
+  // Arrivals do not depend on grants, so the offered load is exactly load.
+  uint64_t backlog;
+  bool holding;
+  request pending;
+  std::deque<request> inflight;
+  unsigned rand_state;
+  // Statistics
+  uint64_t granted, received, mismatch, spurious;
+  uint64_t wait_sum, wait_max, lat_sum, lat_max;
+  double fair;
+};
+static port_state ps[PORTS];
+
+static bool chance(port_state *p, double prob) {
+  return prob >= 1.0 || rand_r(&p->rand_state) < prob * RAND_MAX;
+}
+
+// One clock cycle. New requests arrive and are presented only while
+// issuing; consumers always accept once draining.
+static void step(bool issuing) {
+  uint64_t cycles = sim.cycles;
+  for (int i = 0; i < PORTS; i++) {
+    port_state *p = &ps[i];
+    if (issuing && chance(p, p->load))
+      p->backlog++;
+    if (issuing && !p->holding && p->backlog > 0) {
+      p->backlog--;
+      p->holding = true;
+      p->pending.in = tb_mixed_input(&p->rand_state);
+      p->pending.req_cycle = cycles;
+    }
+    *port[i].in_valid = p->holding;
+    *port[i].in_bits = p->pending.in;
+    *port[i].in_rm = 0;
+    *port[i].out_ready = !issuing || chance(p, p->ready);
+  }
+
+  top->eval();
+  bool in_fire[PORTS], out_fire[PORTS];
+  uint32_t out_bits[PORTS];
+  for (int i = 0; i < PORTS; i++) {
+    in_fire[i] = *port[i].in_valid && *port[i].in_ready;
+    out_fire[i] = *port[i].out_valid && *port[i].out_ready;
+    out_bits[i] = *port[i].out_bits;
+  }
+  tb_sim_cycle(&sim);
+
+  for (int i = 0; i < PORTS; i++) {
+    port_state *p = &ps[i];
+    if (in_fire[i]) {
+      p->pending.grant_cycle = cycles;
+      p->inflight.push_back(p->pending);
+      p->holding = false;
+      p->granted++;
+      uint64_t wait = cycles - p->pending.req_cycle;
+      p->wait_sum += wait;
+      if (wait > p->wait_max)
+        p->wait_max = wait;
+    }
+    if (out_fire[i]) {
+      if (p->inflight.empty()) {
+        if (p->spurious++ < 10)
+          printf("Spurious: port %d cycle %lu dut 0x%08x\n", i, cycles,
+                 out_bits[i]);
+        continue;
+      }
+      request r = p->inflight.front();
+      p->inflight.pop_front();
+      p->received++;
+      uint64_t lat = cycles - r.req_cycle;
+      p->lat_sum += lat;
+      if (lat > p->lat_max)
+        p->lat_max = lat;
+      uint32_t expect = tanh_model_eval(&model, r.in);
+      if (out_bits[i] != expect && p->mismatch++ < 10)
+        printf("Mismatch: port %d in 0x%08x dut 0x%08x model 0x%08x\n", i,
+               r.in, out_bits[i], expect);
+    }
+  }
+}
+
+// Weighted max-min fair shares of a core that serves one request per cycle:
+// demands below the weighted share are met in full, and what they leave
+// is split again by weight among the others
+static void fair_shares() {
+  bool fixed[PORTS] = {false};
+  double capacity = 1.0;
+  for (;;) {
+    double wsum = 0, level = capacity;
+    for (int i = 0; i < PORTS; i++)
+      if (!fixed[i])
+        wsum += ps[i].weight;
+    if (wsum == 0)
+      return;
+    bool changed = false;
+    for (int i = 0; i < PORTS; i++) {
+      double demand = ps[i].load < ps[i].ready ? ps[i].load : ps[i].ready;
+      if (!fixed[i] && demand <= level * ps[i].weight / wsum) {
+        ps[i].fair = demand;
+        fixed[i] = true;
+        capacity -= demand;
+        changed = true;
+      }
+    }
+    if (!changed) {
+      for (int i = 0; i < PORTS; i++)
+        if (!fixed[i])
+          ps[i].fair = capacity * ps[i].weight / wsum;
+      return;
+    }
+  }
+}
+
+// Comma-separated list into PORTS values; the last one repeats
+static bool parse_list(const char *arg, double *vals) {
+  char buf[256];
+  snprintf(buf, sizeof(buf), "%s", arg);
+  int n = 0;
+  for (char *tok = strtok(buf, ","); tok && n < PORTS;
+       tok = strtok(NULL, ","))
+    vals[n++] = atof(tok);
+  if (n == 0)
+    return false;
+  for (; n < PORTS; n++)
+    vals[n] = vals[n - 1];
+  return true;
+}
+
+static void usage(const char *prog) {
+  printf("Usage: %s [options]\n", prog);
+  printf("  --cycles N          Cycles of request traffic (default: "
+         "200000)\n");
+  printf("  --load LIST         Per-port request probability per cycle, "
+         "comma-separated,\n"
+         "                      last repeats (default: 1)\n");
+  printf("  --ready LIST        Per-port probability of accepting a result "
+         "(default: 1)\n");
+  printf("  --weights LIST      Arbiter weights the RTL was built with "
+         "(default: 1)\n");
+  printf("  --seed S            Random seed (default: 1)\n");
+  printf("  --lut FILE          Coefficient file of the RTL (default: "
+         "lut.txt)\n");
+}
+
+int main(int argc, char **argv) {
+  const char *lut_file = "lut.txt";
+  unsigned seed = 1;
+  uint64_t n_cycles = 200000;
+  double load[PORTS], ready[PORTS], weight[PORTS];
+  parse_list("1", load);
+  parse_list("1", ready);
+  parse_list("1", weight);
+
+  static struct option long_opts[] = {
+      {"cycles", required_argument, NULL, 'n'},
+      {"load", required_argument, NULL, 'L'},
+      {"ready", required_argument, NULL, 'r'},
+      {"weights", required_argument, NULL, 'w'},
+      {"seed", required_argument, NULL, 's'},
+      {"lut", required_argument, NULL, 'l'},
+      {"help", no_argument, NULL, 'h'},
+      {NULL, 0, NULL, 0}};
+  int opt;
+  bool ok = true;
+  while ((opt = getopt_long(argc, argv, "h", long_opts, NULL)) != -1) {
+    switch (opt) {
+    case 'n':
+      n_cycles = strtoull(optarg, NULL, 0);
+      break;
+    case 'L':
+      ok &= parse_list(optarg, load);
+      break;
+    case 'r':
+      ok &= parse_list(optarg, ready);
+      break;
+    case 'w':
+      ok &= parse_list(optarg, weight);
+      break;
+    case 's':
+      seed = strtoul(optarg, NULL, 0);
+      break;
+    case 'l':
+      lut_file = optarg;
+      break;
+    default:
+      usage(argv[0]);
+      return opt == 'h' ? 0 : 1;
+    }
+  }
+  for (int i = 0; i < PORTS; i++)
+    ok &= load[i] >= 0 && load[i] <= 1 && ready[i] > 0 && ready[i] <= 1 &&
+          weight[i] >= 1;
+  if (!ok || n_cycles == 0) {
+    printf("Error: Need cycles > 0, loads in [0, 1], ready in (0, 1] and "
+           "weights >= 1\n");
+    return 1;
+  }
+  tanh_model_init(&model);
+  if (!tanh_model_load_lut(&model, lut_file))
+    return 1;
+
+  for (int i = 0; i < PORTS; i++) {
+    ps[i].load = load[i];
+    ps[i].ready = ready[i];
+    ps[i].weight = (int)weight[i];
+    ps[i].rand_state = seed * 1000003u + i;
+  }
+  fair_shares();
+
+  printf("\n=== TANHFP32Shared Arbitration Test ===\n");
+  printf("Ports %d, %lu cycles of traffic\n", PORTS, n_cycles);
+
+  sim_init();
+  while (sim.cycles < n_cycles)
+    step(true);
+  // Drain until every request is answered or the watchdog fires
+  tb_watchdog watchdog;
+  tb_watchdog_init(&watchdog, 10000);
+  for (;;) {
+    bool outstanding = false;
+    uint64_t received = 0;
+    for (int i = 0; i < PORTS; i++) {
+      outstanding |= !ps[i].inflight.empty();
+      received += ps[i].received;
+    }
+    if (!outstanding || tb_watchdog_expired(&watchdog, received))
+      break;
+    step(false);
+  }
+
+  printf("\n%-4s %6s %5s %5s %10s %8s %8s %12s %12s\n", "Port", "Weight",
+         "Load", "Ready", "Granted", "Rate", "Fair", "Wait avg/max",
+         "Lat avg/max");
+  printf("----------------------------------------------------------------"
+         "-------------\n");
+  uint64_t granted = 0, mismatch = 0, spurious = 0, lost = 0;
+  double sum = 0, sum_sq = 0;
+  int fair_ports = 0, short_ports = 0;
+  for (int i = 0; i < PORTS; i++) {
+    port_state *p = &ps[i];
+    double rate = (double)p->granted / n_cycles;
+    printf("%-4d %6d %5.2f %5.2f %10lu %8.4f %8.4f %7.1f/%-4lu %7.1f/%-4lu\n",
+           i, p->weight, p->load, p->ready, p->granted, rate, p->fair,
+           p->granted ? (double)p->wait_sum / p->granted : 0.0, p->wait_max,
+           p->received ? (double)p->lat_sum / p->received : 0.0, p->lat_max);
+    granted += p->granted;
+    mismatch += p->mismatch;
+    spurious += p->spurious;
+    lost += p->inflight.size();
+    if (p->fair > 0) {
+      double x = rate / p->fair;
+      sum += x;
+      sum_sq += x * x;
+      fair_ports++;
+      short_ports += x < 1.0 - FAIR_TOL;
+    }
+  }
+  // Jain's index of throughput normalised by fair share: 1 is ideal,
+  // 1/ports is one port taking everything
+  double jain = sum_sq > 0 ? sum * sum / (fair_ports * sum_sq) : 0.0;
+
+  printf("\nAggregate throughput: %.4f results/cycle\n",
+         (double)granted / n_cycles);
+  printf("Jain fairness:        %.4f over %d ports with demand (min %.2f)\n",
+         jain, fair_ports, JAIN_MIN);
+  printf("Below fair share:     %d ports (by more than %.0f%%)\n",
+         short_ports, FAIR_TOL * 100);
+  printf("Model mismatches:     %lu\n", mismatch);
+  printf("Spurious responses:   %lu\n", spurious);
+  printf("Lost responses:       %lu\n", lost);
+
+  bool pass = mismatch == 0 && spurious == 0 && lost == 0 &&
+              short_ports == 0 && (fair_ports == 0 || jain >= JAIN_MIN);
+  printf("\n%s\n", pass ? "PASSED" : "FAILED");
+  tb_sim_free(&sim);
+  return pass ? 0 : 1;
+}
@@ -0,0 +1,203 @@
+#include "TANHFP32_stats.h"
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+uint64_t compute_ulp(float golden, float hardware) {
+  union {
+    float f;
+    uint32_t u;
+  } g, h;
+  g.f = golden;
+  h.f = hardware;
+
+  if (std::isnan(g.f) && std::isnan(h.f))
+    return 0;
+  if (std::isinf(g.f) && std::isinf(h.f) &&
+      ((g.u & 0x80000000) == (h.u & 0x80000000)))
+    return 0;
+  if (g.f == h.f)
+    return 0;
+
+  bool g_neg = (g.u >> 31) & 1;
+  bool h_neg = (h.u >> 31) & 1;
+
+  if (g_neg != h_neg) {
+    uint32_t g_mag = g.u & 0x7FFFFFFF;
+    uint32_t h_mag = h.u & 0x7FFFFFFF;
+    return (uint64_t)g_mag + (uint64_t)h_mag;
+  }
+
+  if (g.u > h.u)
+    return (uint64_t)(g.u - h.u);
+  else
+    return (uint64_t)(h.u - g.u);
+}
+
+void error_stats_update(error_stats *stats, const float *vin, const float *dut,
+                        const float *ref, int n, double err_threshold,
+                        uint64_t ulp_threshold, bool print_failures) {
+  for (int i = 0; i < n; i++) {
+    double g = (double)ref[i];
+    double h = (double)dut[i];
+    double err;
+    uint64_t ulp = compute_ulp(ref[i], dut[i]);
+
+    if (std::isnan(g) && std::isnan(h)) {
+      err = 0.0;
+    } else if (std::isinf(g) && std::isinf(h)) {
+      err = 0.0;
+    } else {
+      err = fabs((h - g) / ((g == 0.0 || h == 0.0) ? 1.0 : g));
+    }
+
+    stats->total_err += err;
+    stats->total_ulp += ulp;
+    if (err > stats->max_err)
+      stats->max_err = err;
+    if (ulp > stats->max_ulp)
+      stats->max_ulp = ulp;
+
+    if ((std::isnan(g) && std::isnan(h)) || (std::isinf(g) && std::isinf(h))) {
+      stats->pass++;
+    } else if (err < err_threshold && ulp <= ulp_threshold) {
+      stats->pass++;
+    } else {
+      stats->fail++;
+      if (print_failures) {
+        printf("%+13.6e %+13.6e %+13.6e %13.6e %13lu\n", vin[i], ref[i], dut[i],
+               err, ulp);
+      }
+    }
+  }
+  stats->n += n;
+}
+
+void error_stats_merge(error_stats *dst, const error_stats *src) {
+  dst->n += src->n;
+  dst->pass += src->pass;
+  dst->fail += src->fail;
+  dst->total_err += src->total_err;
+  dst->total_ulp += src->total_ulp;
+  if (src->max_err > dst->max_err)
+    dst->max_err = src->max_err;
+  if (src->max_ulp > dst->max_ulp)
+    dst->max_ulp = src->max_ulp;
+}
+
+void error_stats_print(const error_stats *stats, const char *ref_name) {
+  uint64_t n = stats->n;
+  printf("\n=== %s Statistics ===\n", ref_name);
+  printf("Total=%lu, Pass=%lu (%.2f%%), Fail=%lu (%.2f%%)\n", n, stats->pass,
+         (stats->pass * 100.0 / n), stats->fail, (stats->fail * 100.0 / n));
+  printf("AvgErr=%e, MaxErr=%e\n", stats->total_err / n, stats->max_err);
+  printf("AvgULP=%.2f, MaxULP=%lu\n", (double)stats->total_ulp / n,
+         stats->max_ulp);
+}
+
+void compute_error_stats(const float *vin, const float *dut, const float *ref,
+                         int n, double err_threshold, uint64_t ulp_threshold,
+                         bool print_failures, const char *ref_name) {
+  error_stats stats;
+  memset(&stats, 0, sizeof(stats));
+
+  if (print_failures) {
+    printf("\n%13s %13s %13s %13s %13s\n", "Input", "Reference", "DUT", "Error",
+           "ULP");
+    printf(
+        "---------------------------------------------------------------------"
+        "----\n");
+  }
+
+  error_stats_update(&stats, vin, dut, ref, n, err_threshold, ulp_threshold,
+                     print_failures);
+  error_stats_print(&stats, ref_name);
+}
+
+error_hist *error_hist_alloc() {
+  return (error_hist *)calloc(1, sizeof(error_hist));
+}
+
+void error_hist_free(error_hist *hist) { free(hist); }
+
+// 0 for 0, else 1 + floor(log2(v))
+static inline int log2_bucket(uint64_t v) {
+  return v ? 64 - __builtin_clzll(v) : 0;
+}
+
+static inline int64_t ordered_bits(float f) {
+  uint32_t u;
+  memcpy(&u, &f, sizeof(u));
+  return (u >> 31) ? -(int64_t)(u & 0x7FFFFFFF) : (int64_t)u;
+}
+
+void error_hist_update(error_hist *hist, const float *vin, const float *dut,
+                       const float *ref, int n) {
+  const int zero_row = HIST_ULP_BINS - 1;
+
+  for (int i = 0; i < n; i++) {
+    uint32_t x;
+    memcpy(&x, &vin[i], sizeof(x));
+    int col = (x >> (23 - HIST_MANT_BITS)) & (HIST_X_BINS - 1);
+
+    int ulp_row = log2_bucket(compute_ulp(ref[i], dut[i]));
+    hist->ulp[ulp_row < HIST_ULP_BINS ? ulp_row : HIST_ULP_BINS - 1][col]++;
+
+    // A NaN on one side only has no signed distance
+    bool g_nan = std::isnan(ref[i]), h_nan = std::isnan(dut[i]);
+    if (g_nan != h_nan)
+      continue;
+    int64_t d = g_nan ? 0 : ordered_bits(dut[i]) - ordered_bits(ref[i]);
+    int mag = log2_bucket(d < 0 ? -d : d);
+    if (mag > zero_row)
+      mag = zero_row;
+    hist->serr[d < 0 ? zero_row - mag : zero_row + mag][col]++;
+  }
+}
+
+void error_hist_merge(error_hist *dst, const error_hist *src) {
+  for (int r = 0; r < HIST_ULP_BINS; r++)
+    for (int c = 0; c < HIST_X_BINS; c++)
+      dst->ulp[r][c] += src->ulp[r][c];
+  for (int r = 0; r < HIST_SERR_BINS; r++)
+    for (int c = 0; c < HIST_X_BINS; c++)
+      dst->serr[r][c] += src->serr[r][c];
+}
+
+static void save_npy(const char *filename, const uint64_t *data, int rows,
+                     int cols) {
+  FILE *fp = fopen(filename, "wb");
+  if (!fp) {
+    printf("Warning: Failed to save %s.\n", filename);
+    return;
+  }
+
+  // NPY v1.0: magic, version, header length, then a dict padded so the data
+  // starts on a 64-byte boundary
+  char header[128];
+  int len = snprintf(header, sizeof(header),
+                     "{'descr': '<u8', 'fortran_order': False, "
+                     "'shape': (%d, %d), }",
+                     rows, cols);
+  int total = (10 + len + 1 + 63) / 64 * 64;
+  while (10 + len + 1 < total)
+    header[len++] = ' ';
+  header[len++] = '\n';
+
+  uint16_t hlen = len;
+  fwrite("\x93NUMPY\x01\x00", 1, 8, fp);
+  fwrite(&hlen, sizeof(hlen), 1, fp);
+  fwrite(header, 1, len, fp);
+  fwrite(data, sizeof(uint64_t), (size_t)rows * cols, fp);
+  fclose(fp);
+}
+
+void error_hist_save(const error_hist *hist, const char *prefix) {
+  char filename[512];
+  printf("Saving error heatmaps to %s_{ulp,serr}.npy...\n", prefix);
+  snprintf(filename, sizeof(filename), "%s_ulp.npy", prefix);
+  save_npy(filename, &hist->ulp[0][0], HIST_ULP_BINS, HIST_X_BINS);
+  snprintf(filename, sizeof(filename), "%s_serr.npy", prefix);
+  save_npy(filename, &hist->serr[0][0], HIST_SERR_BINS, HIST_X_BINS);
+}
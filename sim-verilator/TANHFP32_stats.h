@@ -0,0 +1,62 @@
+#ifndef __TANHFP32_STATS_H__
+#define __TANHFP32_STATS_H__
+
+#include <cstdint>
+
+struct error_stats {
+  uint64_t n;
+  uint64_t pass;
+  uint64_t fail;
+  double total_err;
+  double max_err;
+  uint64_t total_ulp;
+  uint64_t max_ulp;
+};
+
+// Fixed-size 2D error histograms, filled during the run so any run size
+// (up to the exhaustive sweep) plots from about 1.6 MB.
+//
+// Columns bucket |x| by biased exponent and the top HIST_MANT_BITS mantissa
+// bits. ULP rows are 0, then one per power of two (1, 2-3, 4-7, ...).
+// Signed rows are the same buckets for dut - ref in ordered-integer space,
+// negative below the zero row and positive above it.
+#define HIST_MANT_BITS 3
+#define HIST_X_BINS (256 << HIST_MANT_BITS)
+#define HIST_ULP_BINS 34
+#define HIST_SERR_BINS (2 * (HIST_ULP_BINS - 1) + 1)
+
+struct error_hist {
+  uint64_t ulp[HIST_ULP_BINS][HIST_X_BINS];
+  uint64_t serr[HIST_SERR_BINS][HIST_X_BINS];
+};
+
+uint64_t compute_ulp(float golden, float hardware);
+
+// Accumulates one batch into stats; can be called repeatedly on chunks
+void error_stats_update(error_stats *stats, const float *vin, const float *dut,
+                        const float *ref, int n, double err_threshold,
+                        uint64_t ulp_threshold, bool print_failures);
+
+// Adds the counts of src into dst, e.g. per-thread partials of one chunk
+void error_stats_merge(error_stats *dst, const error_stats *src);
+
+void error_stats_print(const error_stats *stats, const char *ref_name);
+
+void compute_error_stats(const float *vin, const float *dut, const float *ref,
+                         int n, double err_threshold, uint64_t ulp_threshold,
+                         bool print_failures, const char *ref_name);
+
+error_hist *error_hist_alloc();
+
+void error_hist_free(error_hist *hist);
+
+void error_hist_update(error_hist *hist, const float *vin, const float *dut,
+                       const float *ref, int n);
+
+// Adds the counts of src into dst, e.g. per-environment histograms
+void error_hist_merge(error_hist *dst, const error_hist *src);
+
+// Writes <prefix>_ulp.npy and <prefix>_serr.npy (uint64, rows x columns)
+void error_hist_save(const error_hist *hist, const char *prefix);
+
+#endif
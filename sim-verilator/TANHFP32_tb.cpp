@@ -0,0 +1,247 @@
+#include "TANHFP32_tb.h"
+#include "TANHFP32_cov.h"
+#include "TANHFP32_model.h"
+#include <VTANHFP32.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <thread>
+
+const char *tb_phase_name[TB_PHASE_NUM] = {
+    "init", "generate", "reference", "drive", "stats", "output"};
+
+double tb_now() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static uint32_t float_bits(float f) {
+  uint32_t u;
+  memcpy(&u, &f, sizeof(u));
+  return u;
+}
+
+static float bits_float(uint32_t u) {
+  float f;
+  memcpy(&f, &u, sizeof(f));
+  return f;
+}
+
+static int take(tb_source *src, int n) {
+  uint64_t left = src->end - src->next;
+  return left < (uint64_t)n ? (int)left : n;
+}
+
+static int fill_random(tb_source *src, float *vin, int n) {
+  n = take(src, n);
+  for (int i = 0; i < n; i++)
+    vin[i] = ((float)rand_r(&src->rng) / RAND_MAX) * 10.0 - 1.0;
+  src->next += n;
+  return n;
+}
+
+static int fill_range(tb_source *src, float *vin, int n) {
+  n = take(src, n);
+  for (int i = 0; i < n; i++)
+    vin[i] = bits_float((uint32_t)(src->next + i));
+  src->next += n;
+  return n;
+}
+
+static int fill_list(tb_source *src, float *vin, int n) {
+  n = take(src, n);
+  memcpy(vin, src->list + src->next, sizeof(float) * n);
+  src->next += n;
+  return n;
+}
+
+void tb_source_random(tb_source *src, unsigned seed, uint64_t count) {
+  memset(src, 0, sizeof(*src));
+  src->fill = fill_random;
+  src->rng = seed;
+  src->end = count;
+}
+
+void tb_source_range(tb_source *src, uint64_t lo, uint64_t hi) {
+  memset(src, 0, sizeof(*src));
+  src->fill = fill_range;
+  src->next = lo;
+  src->end = hi;
+}
+
+void tb_source_list(tb_source *src, const float *list, int n) {
+  memset(src, 0, sizeof(*src));
+  src->fill = fill_list;
+  src->list = list;
+  src->end = n;
+}
+
+// Before the rising edge: this cycle's inputs, and whether they fire
+static void driver_drive(tb_driver *d, VTANHFP32 *top) {
+  if (d->backpressure > 0.0) {
+    top->io_out_ready = rand_r(&d->rng) >= d->backpressure * RAND_MAX;
+    // io_in_ready follows io_out_ready through the ready chain
+    top->eval();
+  }
+  top->io_in_valid = d->issued < d->n;
+  if (d->issued < d->n) {
+    top->io_in_bits_in = float_bits(d->vin[d->issued]);
+    top->io_in_bits_rm = 0;
+  }
+  d->in_fire = top->io_in_valid && top->io_in_ready;
+  d->issue_stalled |= top->io_in_valid && !top->io_in_ready;
+}
+
+// After the rising edge
+static void driver_commit(tb_driver *d, uint8_t *stall) {
+  if (!d->in_fire)
+    return;
+  if (stall)
+    stall[d->issued] = d->issue_stalled ? COV_STALL_ISSUE : 0;
+  d->issue_stalled = false;
+  d->issued++;
+}
+
+static void monitor_sample(tb_monitor *m, VTANHFP32 *top) {
+  m->out_fire = top->io_out_valid && top->io_out_ready;
+  m->out_bits = top->io_out_bits_out;
+  m->drain_stalled |= top->io_out_valid && !top->io_out_ready;
+}
+
+static void monitor_commit(tb_monitor *m, uint8_t *stall) {
+  if (!m->out_fire)
+    return;
+  if (stall)
+    stall[m->received] |= m->drain_stalled ? COV_STALL_DRAIN : 0;
+  m->drain_stalled = false;
+  m->vout[m->received++] = bits_float(m->out_bits);
+}
+
+void tb_scoreboard_init(tb_scoreboard *sb, const ref_provider *const *list,
+                        int n, int cap, int threads, bool print_failures,
+                        const tanh_model *model) {
+  ref_set_init(&sb->refs, list, n, cap, threads, model);
+  sb->err_threshold = 1e-4;
+  sb->ulp_threshold = 2;
+  sb->print_failures = print_failures;
+}
+
+void tb_scoreboard_free(tb_scoreboard *sb) { ref_set_free(&sb->refs); }
+
+void tb_scoreboard_check(tb_scoreboard *sb, const float *vin, const float *dut,
+                         int n) {
+  ref_set_check(&sb->refs, vin, dut, n, sb->err_threshold, sb->ulp_threshold,
+                sb->print_failures);
+}
+
+void tb_env_init(tb_env *env, const tb_env_config *cfg) {
+  double start = tb_now();
+  memset(env, 0, sizeof(*env));
+  env->id = cfg->id;
+  env->batch = cfg->batch;
+  env->vin = (float *)malloc(sizeof(float) * cfg->batch);
+  env->dut = (float *)malloc(sizeof(float) * cfg->batch);
+  env->stall = (uint8_t *)malloc(cfg->batch);
+  env->driver.backpressure = cfg->backpressure;
+  env->driver.rng = cfg->seed;
+  if (cfg->model) {
+    env->model = (tanh_model *)malloc(sizeof(tanh_model));
+    memcpy(env->model, cfg->model, sizeof(tanh_model));
+  }
+  tb_scoreboard_init(&env->sb, cfg->refs, cfg->ref_count, cfg->batch,
+                     cfg->ref_threads, cfg->print_failures, env->model);
+
+  tb_sim_init(&env->sim, cfg->wave_file);
+  tb_sim_reset(&env->sim, 10);
+  env->phase_time[TB_PHASE_INIT] += tb_now() - start;
+}
+
+void tb_env_free(tb_env *env) {
+  tb_sim_free(&env->sim);
+  tb_scoreboard_free(&env->sb);
+  free(env->model);
+  free(env->vin);
+  free(env->dut);
+  free(env->stall);
+}
+
+void tb_env_drive(tb_env *env, const float *vin, float *vout, uint8_t *stall,
+                  int n) {
+  tb_driver *d = &env->driver;
+  tb_monitor *m = &env->monitor;
+  d->vin = vin;
+  d->n = n;
+  d->issued = 0;
+  d->issue_stalled = false;
+  m->vout = vout;
+  m->received = 0;
+  m->drain_stalled = false;
+  env->sim.top->io_out_ready = 1;
+  env->sim.top->io_in_valid = 0;
+
+  while (m->received < n) {
+    driver_drive(d, env->sim.top);
+    monitor_sample(m, env->sim.top);
+    if (env->on_cycle)
+      env->on_cycle(env, d->issued >= n);
+    tb_sim_cycle(&env->sim);
+    driver_commit(d, stall);
+    monitor_commit(m, stall);
+    env->drive_cycles++;
+  }
+  env->results += n;
+}
+
+uint64_t tb_env_run(tb_env *env, tb_source *src, tb_batch_fn done,
+                    void *arg) {
+  uint64_t total = 0;
+  for (;;) {
+    double start = tb_now();
+    int n = src->fill(src, env->vin, env->batch);
+    env->phase_time[TB_PHASE_GENERATE] += tb_now() - start;
+    if (n == 0)
+      break;
+
+    start = tb_now();
+    tb_env_drive(env, env->vin, env->dut, env->stall, n);
+    env->phase_time[TB_PHASE_DRIVE] += tb_now() - start;
+
+    start = tb_now();
+    tb_scoreboard_check(&env->sb, env->vin, env->dut, n);
+    env->phase_time[TB_PHASE_REFERENCE] += tb_now() - start;
+    total += n;
+
+    if (done) {
+      start = tb_now();
+      bool more = done(env, n, arg);
+      env->phase_time[TB_PHASE_STATS] += tb_now() - start;
+      if (!more)
+        break;
+    }
+  }
+  return total;
+}
+
+void tb_env_run_parallel(tb_env *envs, tb_source *srcs, int n,
+                         tb_batch_fn done, void *arg) {
+  std::thread *workers = n > 1 ? new std::thread[n - 1] : NULL;
+  for (int i = 1; i < n; i++)
+    workers[i - 1] = std::thread(tb_env_run, &envs[i], &srcs[i], done, arg);
+  tb_env_run(&envs[0], &srcs[0], done, arg);
+  for (int i = 1; i < n; i++)
+    workers[i - 1].join();
+  delete[] workers;
+}
+
+void tb_env_print_stats(const tb_env *envs, int n) {
+  const ref_set *refs = &envs[0].sb.refs;
+  for (int r = 0; r < refs->n; r++) {
+    error_stats sum;
+    memset(&sum, 0, sizeof(sum));
+    for (int e = 0; e < n; e++)
+      error_stats_merge(&sum, &envs[e].sb.refs.stats[r]);
+    error_stats_print(&sum, refs->provider[r]->label);
+  }
+}
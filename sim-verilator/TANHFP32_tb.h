@@ -0,0 +1,153 @@
+#ifndef __TANHFP32_TB_H__
+#define __TANHFP32_TB_H__
+
+#include "TANHFP32_harness.h"
+#include "TANHFP32_refset.h"
+#include <cstdint>
+
+// Transaction-level testbench environment for TANHFP32.
+//
+// A source produces input transactions in batches. The driver presents them
+// on io_in and drives io_out_ready. The monitor collects the results in
+// order, with the stall flags of each transaction. The scoreboard checks each
+// batch against a ref_set. An environment owns one verilated model with its
+// context and wave trace (a tb_sim), its copy of the software model the scoreboard
+// checks against, plus one of each component. It shares no mutable state
+// with other environments, so several can run on their own threads
+// (tb_env_run_parallel), each against its own DUT variant and LUT.
+
+struct tanh_model;
+class VTANHFP32;
+
+// The reference phase is the fused reference and statistics pass of the
+// scoreboard; the stats phase is what else the run bins per batch
+enum {
+  TB_PHASE_INIT,
+  TB_PHASE_GENERATE,
+  TB_PHASE_REFERENCE,
+  TB_PHASE_DRIVE,
+  TB_PHASE_STATS,
+  TB_PHASE_OUTPUT,
+  TB_PHASE_NUM
+};
+
+extern const char *tb_phase_name[TB_PHASE_NUM];
+
+double tb_now();
+
+// Stimulus. fill writes up to n inputs and returns how many, 0 when done.
+struct tb_source {
+  int (*fill)(tb_source *src, float *vin, int n);
+  unsigned rng;
+  uint64_t next, end; // position and end, in vectors or bit patterns
+  const float *list;
+  void *user; // for sources defined by the test
+};
+
+// count inputs in [-1, 9) from the source's own random stream
+void tb_source_random(tb_source *src, unsigned seed, uint64_t count);
+
+// Every bit pattern in [lo, hi)
+void tb_source_range(tb_source *src, uint64_t lo, uint64_t hi);
+
+// The n inputs of list, in order; list must outlive the source
+void tb_source_list(tb_source *src, const float *list, int n);
+
+// Presents the inputs of a batch; holds io_out_ready low with probability
+// backpressure, drawn from its own stream so the stimulus does not depend
+// on it
+struct tb_driver {
+  double backpressure;
+  unsigned rng;
+  const float *vin;
+  int n;
+  int issued;
+  bool in_fire;
+  bool issue_stalled;
+};
+
+// Collects the results of a batch in order
+struct tb_monitor {
+  float *vout;
+  int received;
+  bool out_fire;
+  uint32_t out_bits;
+  bool drain_stalled;
+};
+
+struct tb_scoreboard {
+  ref_set refs;
+  double err_threshold;
+  uint64_t ulp_threshold;
+  bool print_failures;
+};
+
+// model is what the model reference evaluates; NULL if none is selected
+void tb_scoreboard_init(tb_scoreboard *sb, const ref_provider *const *list,
+                        int n, int cap, int threads, bool print_failures,
+                        const tanh_model *model);
+
+void tb_scoreboard_free(tb_scoreboard *sb);
+
+void tb_scoreboard_check(tb_scoreboard *sb, const float *vin, const float *dut,
+                         int n);
+
+struct tb_env_config {
+  int id;
+  const ref_provider *const *refs;
+  int ref_count;
+  int ref_threads; // <= 0 uses every core
+  int batch;       // transactions per batch
+  double backpressure;
+  unsigned seed; // backpressure stream
+  bool print_failures;
+  const char *wave_file; // CONFIG_WAVE_TRACE builds; NULL for no trace
+  const tanh_model *model; // copied into the environment; may be NULL
+};
+
+struct tb_env {
+  int id;
+  tb_sim<VTANHFP32> sim; // cycles include reset
+  tanh_model *model; // own copy, NULL without one
+  uint64_t drive_cycles;
+  uint64_t results;
+  double phase_time[TB_PHASE_NUM];
+  tb_driver driver;
+  tb_monitor monitor;
+  tb_scoreboard sb;
+  // The last batch of tb_env_run
+  int batch;
+  float *vin;
+  float *dut;
+  uint8_t *stall; // COV_STALL_* flags of each transaction
+  // Called every cycle before the rising edge, e.g. by the profilers
+  void (*on_cycle)(tb_env *env, bool draining);
+};
+
+// Called after each batch of tb_env_run has been scored; false stops the
+// run. With tb_env_run_parallel it runs on the environment's thread.
+typedef bool (*tb_batch_fn)(tb_env *env, int n, void *arg);
+
+// Builds the model and holds it in reset for 10 cycles
+void tb_env_init(tb_env *env, const tb_env_config *cfg);
+
+void tb_env_free(tb_env *env);
+
+// Drives n transactions through the DUT until every result is back; stall
+// may be NULL
+void tb_env_drive(tb_env *env, const float *vin, float *vout, uint8_t *stall,
+                  int n);
+
+// Pulls, drives and scores batches until the source runs dry or done
+// returns false; returns the number of transactions
+uint64_t tb_env_run(tb_env *env, tb_source *src, tb_batch_fn done,
+                    void *arg);
+
+// tb_env_run of every envs[i] with srcs[i], each on its own thread
+void tb_env_run_parallel(tb_env *envs, tb_source *srcs, int n,
+                         tb_batch_fn done, void *arg);
+
+// Scoreboard statistics summed over environments with the same references
+void tb_env_print_stats(const tb_env *envs, int n);
+
+#endif
@@ -0,0 +1,331 @@
+// Exhaustive-domain accuracy of a generator configuration, measured on the
+// bit-accurate model instead of the RTL so a design point takes seconds to
+// minutes rather than a 2^32-cycle simulation. Used by dse.py.
+//
+// With --fixup-bound it also emits the fix-up table for that bound: every
+// polynomial input whose error exceeds it, paired with the reference result.
+// With --fixup-out the summary is that of the model with the table applied.
+
+#include "TANHFP32_model.h"
+#include "TANHFP32_ref.h"
+#include "TANHFP32_stats.h"
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <getopt.h>
+
+#define CHUNK (1 << 20)
+
+struct fixup_entry {
+  uint32_t in;
+  uint32_t out;
+  uint64_t ulp;
+};
+
+// Inputs above the bound; grows as the sweep finds them
+static fixup_entry *fixups = NULL;
+static uint64_t fixup_n = 0, fixup_cap = 0;
+static tanh_model model;
+
+static float bits_float(uint32_t u) {
+  float f;
+  memcpy(&f, &u, sizeof(f));
+  return f;
+}
+
+static uint32_t float_bits(float f) {
+  uint32_t u;
+  memcpy(&u, &f, sizeof(u));
+  return u;
+}
+
+// With apply, the collected inputs take the reference result in dut, which
+// is what the model returns once the table is loaded
+static void collect_fixups(const float *vin, float *dut, const float *ref,
+                           int n, uint64_t bound, bool apply) {
+  for (int i = 0; i < n; i++) {
+    uint32_t x = float_bits(vin[i]);
+    if (tanh_model_bypass(x) != TANH_BYPASS_NONE)
+      continue;
+    uint64_t ulp = compute_ulp(ref[i], dut[i]);
+    if (ulp <= bound)
+      continue;
+    if (fixup_n == fixup_cap) {
+      fixup_cap = fixup_cap ? 2 * fixup_cap : 4096;
+      fixups = (fixup_entry *)realloc(fixups, sizeof(fixup_entry) * fixup_cap);
+    }
+    // Keyed on |x|: the model and the RTL apply the sign afterwards
+    fixups[fixup_n].in = x & 0x7FFFFFFF;
+    fixups[fixup_n].out = float_bits(ref[i]) & 0x7FFFFFFF;
+    fixups[fixup_n].ulp = ulp;
+    fixup_n++;
+    if (apply)
+      dut[i] = ref[i];
+  }
+}
+
+static int fixup_cmp(const void *a, const void *b) {
+  uint32_t x = ((const fixup_entry *)a)->in, y = ((const fixup_entry *)b)->in;
+  return x < y ? -1 : x > y;
+}
+
+// Sorts, merges the two signs of one |x|, and prints how many entries each
+// bound from the requested one up to the max error would need
+static void fixup_report(uint64_t bound) {
+  qsort(fixups, fixup_n, sizeof(fixup_entry), fixup_cmp);
+  uint64_t m = 0, max_ulp = 0;
+  for (uint64_t i = 0; i < fixup_n; i++) {
+    if (m && fixups[m - 1].in == fixups[i].in) {
+      if (fixups[i].ulp > fixups[m - 1].ulp)
+        fixups[m - 1].ulp = fixups[i].ulp;
+      continue;
+    }
+    fixups[m++] = fixups[i];
+    if (fixups[i].ulp > max_ulp)
+      max_ulp = fixups[i].ulp;
+  }
+  fixup_n = m;
+
+  printf("\nFix-up entries by ULP bound (max %d in the RTL):\n",
+         TANH_MODEL_MAX_FIXUPS);
+  printf("  %10s %10s\n", "Bound", "Entries");
+  // The requested bound, then each power of two above it
+  for (uint64_t b = bound;; b = 1ull << (64 - __builtin_clzll(b))) {
+    uint64_t count = 0;
+    for (uint64_t i = 0; i < fixup_n; i++)
+      count += fixups[i].ulp > b;
+    printf("  %10lu %10lu\n", b, count);
+    if (b >= max_ulp)
+      break;
+  }
+}
+
+static bool save_fixups(const char *filename) {
+  if (fixup_n > TANH_MODEL_MAX_FIXUPS) {
+    printf("Error: %lu fix-up entries, the RTL holds at most %d; raise "
+           "--fixup-bound.\n",
+           fixup_n, TANH_MODEL_MAX_FIXUPS);
+    return false;
+  }
+  FILE *fp = fopen(filename, "w");
+  if (!fp) {
+    printf("Warning: Failed to save %s.\n", filename);
+    return false;
+  }
+  for (uint64_t i = 0; i < fixup_n; i++)
+    fprintf(fp, "h%08X h%08X\n", fixups[i].in, fixups[i].out);
+  fclose(fp);
+  printf("Saved %lu fix-up entries to %s\n", fixup_n, filename);
+  return true;
+}
+
+static void save_json(const char *filename, const error_stats *stats,
+                      uint64_t lo, uint64_t hi, int64_t fixup_entries) {
+  FILE *fp = fopen(filename, "w");
+  if (!fp) {
+    printf("Warning: Failed to save %s.\n", filename);
+    return;
+  }
+  fprintf(fp, "{\n");
+  fprintf(fp, "  \"range_lo\": %lu,\n", lo);
+  fprintf(fp, "  \"range_hi\": %lu,\n", hi);
+  if (fixup_entries >= 0)
+    fprintf(fp, "  \"fixup_entries\": %ld,\n", fixup_entries);
+  fprintf(fp, "  \"inputs\": %lu,\n", stats->n);
+  fprintf(fp, "  \"pass\": %lu,\n", stats->pass);
+  fprintf(fp, "  \"max_ulp\": %lu,\n", stats->max_ulp);
+  fprintf(fp, "  \"avg_ulp\": %.6f,\n", (double)stats->total_ulp / stats->n);
+  fprintf(fp, "  \"max_err\": %.9e,\n", stats->max_err);
+  fprintf(fp, "  \"avg_err\": %.9e\n", stats->total_err / stats->n);
+  fprintf(fp, "}\n");
+  fclose(fp);
+}
+
+static void usage(const char *prog) {
+  printf("Usage: %s [options]\n", prog);
+  printf("  --lut FILE          Coefficient file (default: lut.txt)\n");
+  printf("  --seg-bits N        Mantissa bits of the LUT index (default: 3)\n");
+  printf("  --degree N          Polynomial degree (default: 2)\n");
+  printf("  --engine E          fma or muladd (default: fma)\n");
+  printf("  --mul-trunc N       Product columns dropped by the multiplier "
+         "(default: 0)\n");
+  printf("  --add-width N       Product bits into the FMA adder (default: "
+         "48)\n");
+  printf("  --fwd-width N       Accumulator bits forwarded between steps "
+         "(default: 24)\n");
+  printf("  --ref R             glibc or cr reference (default: glibc)\n");
+  printf("  --range LO:HI       Bit-pattern range, HI exclusive (default: "
+         "0:0x100000000)\n");
+  printf("  --fixup-bound N     Collect inputs above N ULP into a fix-up "
+         "table\n");
+  printf("  --fixup-out FILE    Write that table to FILE and report the model "
+         "with it\n");
+  printf("  --json FILE         Write the summary to FILE\n");
+  printf("  --heatmap PREFIX    Write error heatmaps to PREFIX_{ulp,serr}.npy\n");
+  printf("  --check-scalar      Also run the scalar model and fail on any "
+         "result that\n");
+  printf("                      differs from the batch one\n");
+}
+
+int main(int argc, char **argv) {
+  const char *lut_file = "lut.txt";
+  int seg_bits = 3, degree = 2, engine = TANH_ENGINE_FMA;
+  int mul_trunc = 0, add_width = TANH_MODEL_FULL_ADD_WIDTH;
+  int fwd_width = TANH_MODEL_MIN_FWD_WIDTH;
+  bool ref_cr = false;
+  uint64_t lo = 0, hi = 1ull << 32;
+  const char *json_file = NULL;
+  const char *fixup_file = NULL;
+  int64_t fixup_bound = -1;
+  const char *heatmap_prefix = NULL;
+  bool check_scalar = false;
+  uint64_t scalar_mismatches = 0;
+  char *end;
+
+  static struct option long_opts[] = {
+      {"lut", required_argument, NULL, 'l'},
+      {"seg-bits", required_argument, NULL, 's'},
+      {"degree", required_argument, NULL, 'd'},
+      {"engine", required_argument, NULL, 'e'},
+      {"mul-trunc", required_argument, NULL, 't'},
+      {"add-width", required_argument, NULL, 'w'},
+      {"fwd-width", required_argument, NULL, 'f'},
+      {"ref", required_argument, NULL, 'r'},
+      {"range", required_argument, NULL, 'g'},
+      {"fixup-bound", required_argument, NULL, 'b'},
+      {"fixup-out", required_argument, NULL, 'o'},
+      {"json", required_argument, NULL, 'j'},
+      {"heatmap", required_argument, NULL, 'H'},
+      {"check-scalar", no_argument, NULL, 'c'},
+      {"help", no_argument, NULL, 'h'},
+      {NULL, 0, NULL, 0}};
+  int opt;
+  while ((opt = getopt_long(argc, argv, "h", long_opts, NULL)) != -1) {
+    switch (opt) {
+    case 'l':
+      lut_file = optarg;
+      break;
+    case 's':
+      seg_bits = atoi(optarg);
+      break;
+    case 'd':
+      degree = atoi(optarg);
+      break;
+    case 'e':
+      engine = strcmp(optarg, "muladd") ? TANH_ENGINE_FMA : TANH_ENGINE_MULADD;
+      break;
+    case 't':
+      mul_trunc = atoi(optarg);
+      break;
+    case 'w':
+      add_width = atoi(optarg);
+      break;
+    case 'f':
+      fwd_width = atoi(optarg);
+      break;
+    case 'r':
+      ref_cr = !strcmp(optarg, "cr");
+      break;
+    case 'g':
+      lo = strtoull(optarg, &end, 0);
+      hi = *end == ':' ? strtoull(end + 1, NULL, 0) : lo + 1;
+      if (hi > 1ull << 32 || lo >= hi) {
+        printf("Error: Invalid range '%s'\n", optarg);
+        return 1;
+      }
+      break;
+    case 'b':
+      fixup_bound = strtoll(optarg, NULL, 0);
+      break;
+    case 'o':
+      fixup_file = optarg;
+      break;
+    case 'j':
+      json_file = optarg;
+      break;
+    case 'H':
+      heatmap_prefix = optarg;
+      break;
+    case 'c':
+      check_scalar = true;
+      break;
+    default:
+      usage(argv[0]);
+      return opt == 'h' ? 0 : 1;
+    }
+  }
+
+  if (fixup_file && fixup_bound < 0) {
+    printf("Error: --fixup-out needs --fixup-bound\n");
+    return 1;
+  }
+  tanh_model_init(&model);
+  if (!tanh_model_configure(&model, seg_bits, degree, engine) ||
+      !tanh_model_configure_datapath(&model, mul_trunc, add_width,
+                                     fwd_width) ||
+      !tanh_model_load_lut(&model, lut_file))
+    return 1;
+
+  float *vin = (float *)malloc(sizeof(float) * CHUNK);
+  float *ref = (float *)malloc(sizeof(float) * CHUNK);
+  float *dut = (float *)malloc(sizeof(float) * CHUNK);
+  float *scalar = check_scalar ? (float *)malloc(sizeof(float) * CHUNK) : NULL;
+  error_hist *hist = heatmap_prefix ? error_hist_alloc() : NULL;
+  error_stats stats;
+  memset(&stats, 0, sizeof(stats));
+
+  printf("Model: seg_bits=%d degree=%d engine=%s mul_trunc=%d add_width=%d "
+         "fwd_width=%d, reference %s\n",
+         seg_bits, degree, engine == TANH_ENGINE_FMA ? "fma" : "muladd",
+         mul_trunc, add_width, fwd_width, ref_cr ? "cr" : "glibc");
+  printf("Sweeping 0x%08lx..0x%08lx (%lu inputs)\n", lo, hi - 1, hi - lo);
+
+  for (uint64_t base = lo; base < hi; base += CHUNK) {
+    int n = hi - base < (uint64_t)CHUNK ? (int)(hi - base) : CHUNK;
+    for (int i = 0; i < n; i++)
+      vin[i] = bits_float((uint32_t)(base + i));
+    if (ref_cr)
+      tanh_ref_cr_batch(vin, ref, n);
+    else
+      tanh_ref_glibc_batch(vin, ref, n);
+    tanh_model_batch(&model, vin, dut, n);
+    // The scalar path evaluates the exact fma datapath with a two-sum, the
+    // batch path with fmaf; at fwd_width 24 they must agree bit for bit
+    if (scalar) {
+      tanh_model_batch_scalar(&model, vin, scalar, n);
+      for (int i = 0; i < n; i++)
+        scalar_mismatches += float_bits(scalar[i]) != float_bits(dut[i]);
+    }
+    if (fixup_bound >= 0)
+      collect_fixups(vin, dut, ref, n, fixup_bound, fixup_file != NULL);
+    error_stats_update(&stats, vin, dut, ref, n, 1e-4, 2, false);
+    if (hist)
+      error_hist_update(hist, vin, dut, ref, n);
+  }
+
+  error_stats_print(&stats, ref_cr ? "CR_Ref" : "CPU_Ref");
+  bool ok = true;
+  if (fixup_bound >= 0) {
+    fixup_report(fixup_bound);
+    if (fixup_file)
+      ok = save_fixups(fixup_file);
+  }
+  if (scalar) {
+    printf("Scalar mismatches: %lu\n", scalar_mismatches);
+    ok = ok && scalar_mismatches == 0;
+  }
+  if (json_file && ok)
+    save_json(json_file, &stats, lo, hi, fixup_file ? (int64_t)fixup_n : -1);
+  if (hist) {
+    error_hist_save(hist, heatmap_prefix);
+    error_hist_free(hist);
+  }
+
+  free(vin);
+  free(ref);
+  free(dut);
+  free(scalar);
+  free(fixups);
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,111 @@
+#!/usr/bin/env python3
+"""
+Split the generated single-file RTL into one file per module
+
+Usage:
+    python split_rtl.py [options]
+
+Options:
+    --input FILE        Generated SystemVerilog (default: rtl/TANHFP32.sv)
+    --output DIR        Output directory (default: build/hier/rtl)
+    --hier PATTERNS     Comma-separated module name patterns to mark as
+                        Verilator hierarchical blocks (default: CMAFP32*)
+    --help              Show this help message
+
+Each module goes to DIR/<module>.sv with the macro preamble (every define in
+it is guarded, so repeating it is harmless) and without firtool's source
+locator comments, which shift whenever an unrelated line of the Scala source
+moves. A file is only rewritten when its content changes, so its timestamp,
+and with it the hierarchical block built from it, survives regenerations
+that did not touch it. DIR/hier.vlt lists the hierarchical blocks.
+
+Examples:
+    # What make hier runs before verilating
+    python split_rtl.py --input rtl/TANHFP32.sv --output build/hier/rtl
+"""
+
+import argparse
+import fnmatch
+import os
+import re
+import sys
+
+
+LOCATOR = re.compile(r'\s*// (src|dependencies)/\S+:\d+:\d+.*$')
+MODULE = re.compile(r'^module (\w+)')
+
+
+def write_if_changed(path, text):
+    try:
+        with open(path) as f:
+            if f.read() == text:
+                return False
+    except FileNotFoundError:
+        pass
+    with open(path, 'w') as f:
+        f.write(text)
+    return True
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description='Split generated RTL into one file per module',
+        formatter_class=argparse.RawDescriptionHelpFormatter,
+        epilog=__doc__
+    )
+    parser.add_argument('--input', default='rtl/TANHFP32.sv',
+                        help='Generated SystemVerilog (default: rtl/TANHFP32.sv)')
+    parser.add_argument('--output', default='build/hier/rtl',
+                        help='Output directory (default: build/hier/rtl)')
+    parser.add_argument('--hier', default='CMAFP32*',
+                        help='Hierarchical block patterns (default: CMAFP32*)')
+
+    args = parser.parse_args()
+
+    try:
+        with open(args.input) as f:
+            lines = [LOCATOR.sub('', line.rstrip('\n')) for line in f]
+    except FileNotFoundError:
+        print(f"Error: File '{args.input}' not found")
+        sys.exit(1)
+
+    preamble, modules, current = [], {}, None
+    for line in lines:
+        m = MODULE.match(line)
+        if m:
+            current = m.group(1)
+            modules[current] = []
+        if current is None:
+            preamble.append(line)
+        else:
+            modules[current].append(line)
+            if line.startswith('endmodule'):
+                current = None
+    if not modules:
+        print(f"Error: No modules in '{args.input}'")
+        sys.exit(1)
+
+    os.makedirs(args.output, exist_ok=True)
+    header = '\n'.join(preamble).rstrip() + '\n\n'
+    changed = [name for name, body in modules.items()
+               if write_if_changed(os.path.join(args.output, f'{name}.sv'),
+                                   header + '\n'.join(body) + '\n')]
+
+    stale = [f for f in os.listdir(args.output)
+             if f.endswith('.sv') and f[:-3] not in modules]
+    for f in stale:
+        os.remove(os.path.join(args.output, f))
+
+    patterns = [p.strip() for p in args.hier.split(',') if p.strip()]
+    blocks = [name for name in modules
+              if any(fnmatch.fnmatchcase(name, p) for p in patterns)]
+    vlt = '`verilator_config\n' + \
+        ''.join(f'hier_block -module "{name}"\n' for name in blocks)
+    write_if_changed(os.path.join(args.output, 'hier.vlt'), vlt)
+
+    print(f"{len(modules)} modules, {len(changed)} changed, "
+          f"{len(stale)} removed; hierarchical blocks: {', '.join(blocks) or 'none'}")
+
+
+if __name__ == '__main__':
+    main()
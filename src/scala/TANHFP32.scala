@@ -11,14 +11,166 @@ object TANHFP32Parameters {
   val ZERO    = "h00000000".U(32.W)
   val NAN     = "h7FC00000".U(32.W)
   
-  def loadLUT(filename: String): Seq[(Int, String, String, String)] = {
+  // Each line: index, then c0 .. c<degree> as Chisel hex literals
+  def loadLUT(filename: String): Seq[(Int, Seq[String])] = {
     Source.fromFile(filename).getLines()
       .filterNot(_.trim.isEmpty)
       .map { line =>
         val parts = line.trim.split("\\s+")
-        (parts(0).toInt, parts(1), parts(2), parts(3))
+        (parts(0).toInt, parts.drop(1).toSeq)
       }.toSeq.sortBy(_._1)
   }
+  
+  // Same limit as TANH_MODEL_MAX_FIXUPS
+  val MAX_FIXUPS = 1024
+  
+  // Each line: |x| and its corrected |tanh(x)|, as Chisel hex literals
+  def loadFixups(filename: String): Seq[(BigInt, BigInt)] = {
+    val fixups = Source.fromFile(filename).getLines()
+      .filterNot(_.trim.isEmpty)
+      .map { line =>
+        val parts = line.trim.split("\\s+")
+        (BigInt(parts(0).drop(1), 16), BigInt(parts(1).drop(1), 16))
+      }.toSeq
+    require(fixups.length <= MAX_FIXUPS, s"$filename has more than $MAX_FIXUPS fix-up entries")
+    // Two hits on one key would OR their outputs in the CAM's Mux1H
+    require(fixups.map(_._1).distinct.length == fixups.length, s"$filename has duplicate fix-up keys")
+    fixups.foreach { case (in, out) =>
+      val exp = (in >> 23).toInt
+      require(exp >= 122 && exp < 130 && out < (BigInt(1) << 31),
+        s"fix-up entry h${in.toString(16)} h${out.toString(16)} is outside the polynomial domain")
+    }
+    fixups
+  }
+}
+
+// Which handshake registers are present, in datapath order
+case class TANHFP32PipeConfig(
+  filter:  Boolean      = true,
+  segment: Boolean      = true,
+  lut:     Boolean      = true,
+  mul:     Seq[Boolean] = Seq(true, true, true),
+  add:     Seq[Boolean] = Seq(true, true),
+  out:     Boolean      = true
+) {
+  require(mul.length == 3 && add.length == 2)
+  
+  def latency(degree: Int): Int =
+    Seq(filter, segment, lut, out).count(b => b) + degree * (mul ++ add).count(b => b)
+}
+
+object TANHFP32PipeConfig {
+  // "111111111": filter, segment, lut, mul s1-s3, add s1-s2, out
+  def fromString(bits: String): TANHFP32PipeConfig = {
+    require(bits.length == 9 && bits.forall("01".contains(_)),
+      s"pipe flags must be 9 of 0/1, got '$bits'")
+    val b = bits.map(_ == '1')
+    TANHFP32PipeConfig(b(0), b(1), b(2), b.slice(3, 6), b.slice(6, 8), b(8))
+  }
+}
+
+// Generator parameters. The defaults are the configuration of the committed
+// rtl/TANHFP32.sv; make rtl-check elaborates them and diffs the result
+// module by module, source locators aside.
+//   segBits: mantissa bits of the LUT index, 8 << segBits regions over [2^-5, 8)
+//   degree:  polynomial degree, one CMAFP32 per Horner step
+//   engine:  "fma" rounds each step once, "muladd" rounds the product first
+//   mulTrunc:  product columns dropped by a truncated multiplier, 0 for exact
+//   addWidth:  product significand bits into the FMA adder, 48 for exact
+//   fwdWidth:  significand bits of the accumulator one CMA forwards to the
+//              next; 24 rounds it to FP32, wider rounds it that much finer
+//   inFormat:  "fp32", or "int8"/"int16" fixed point scaled by 2^-inFrac
+//   outFormat: "fp32", "bf16", or "int8"/"int16" saturated and scaled by 2^outFrac
+//   fixupFile: optional fix-up table, |x| -> |tanh(x)| pairs matched by a CAM
+//              in the filter stage in place of the polynomial
+//   tagWidth:  bits of an opaque request tag carried alongside each
+//              transaction and returned with its result, 0 for none
+case class TANHFP32Config(
+  segBits:   Int                = 3,
+  degree:    Int                = 2,
+  engine:    String             = "fma",
+  pipe:      TANHFP32PipeConfig = TANHFP32PipeConfig(),
+  mulTrunc:  Int                = 0,
+  addWidth:  Int                = 48,
+  fwdWidth:  Int                = 24,
+  inFormat:  String             = "fp32",
+  outFormat: String             = "fp32",
+  lutFile:   String             = "lut.txt",
+  fixupFile: Option[String]     = None,
+  tagWidth:  Int                = 0
+) {
+  require(segBits >= 0 && segBits <= 6, s"segBits $segBits out of range 0..6")
+  require(degree >= 1 && degree <= 3, s"degree $degree out of range 1..3")
+  require(Seq("fma", "muladd").contains(engine), s"unknown engine '$engine'")
+  require(mulTrunc >= 0 && mulTrunc <= 24, s"mulTrunc $mulTrunc out of range 0..24")
+  require(addWidth >= 26 && addWidth <= 48, s"addWidth $addWidth out of range 26..48")
+  require(fwdWidth >= 24 && fwdWidth <= 29, s"fwdWidth $fwdWidth out of range 24..29")
+  require(fwdWidth == 24 || (engine == "fma" && mulTrunc == 0 && addWidth == 48),
+    "fwdWidth > 24 needs the exact fma datapath")
+  require(Seq("fp32", "int8", "int16").contains(inFormat), s"unknown input format '$inFormat'")
+  require(Seq("fp32", "bf16", "int8", "int16").contains(outFormat), s"unknown output format '$outFormat'")
+  require(tagWidth >= 0 && tagWidth <= 8, s"tagWidth $tagWidth out of range 0..8")
+  
+  def indexWidth: Int = 3 + segBits
+  def regions: Int    = 1 << indexWidth
+  
+  def inWidth: Int  = TANHFP32Format.width(inFormat)
+  def outWidth: Int = TANHFP32Format.width(outFormat)
+  // Scale ports exist only for fixed-point formats; 0 leaves them out
+  def inFracWidth: Int  = if (inFormat.startsWith("int")) 4 else 0
+  def outFracWidth: Int = if (outFormat.startsWith("int")) 4 else 0
+}
+
+// Conversions around the FP32 core for the quantized formats, all exact or
+// rounded once to nearest even
+object TANHFP32Format {
+  def width(format: String): Int = format match {
+    case "fp32"  => 32
+    case "bf16"  => 16
+    case "int16" => 16
+    case "int8"  => 8
+  }
+  
+  // q * 2^-frac, exact since |q| <= 2^15 fits the 24-bit significand
+  def fixedToFP32(q: UInt, frac: UInt): UInt = {
+    val w    = q.getWidth
+    val sign = q(w - 1)
+    val mag  = Mux(sign, (~q).asUInt + 1.U, q)(w - 1, 0)
+    val lz   = PriorityEncoder(Reverse(mag))
+    val norm = (mag << lz)(w - 1, 0)
+    val exp  = (127 + w - 1).U(8.W) - lz - frac
+    Mux(mag === 0.U, 0.U(32.W), Cat(sign, exp, norm(w - 2, 0), 0.U((24 - w).W)))
+  }
+  
+  // Round to nearest even at 2^-frac and saturate to the signed w-bit range;
+  // NaN gives 0
+  def fp32ToFixed(x: UInt, frac: UInt, w: Int): UInt = {
+    val sign  = x(31)
+    val exp   = x(30, 23)
+    val isNaN = exp === "hFF".U && x(22, 0) =/= 0.U
+    val sig   = Cat(exp =/= 0.U, x(22, 0))
+    // Integer part is sig >> (150 - frac - exp); keep 26 bits below it for
+    // the round and sticky bits, everything further down rounds to 0
+    val big   = exp +& frac >= (127 + w - 1).U
+    val shAmt = 150.U(8.W) - frac - exp
+    val sh    = Mux(big || shAmt > 26.U, 26.U, shAmt)
+    val full  = Cat(sig, 0.U(26.W)) >> sh
+    val ipart = full(49, 26)
+    val round = full(25)
+    val stick = full(24, 0).orR
+    val mag   = ipart +& (round && (stick || ipart(0)))
+    val limit = (1 << (w - 1)).U
+    val sat   = big || mag >= limit
+    val pos   = Mux(sat, (limit - 1.U)(w - 1, 0), mag(w - 1, 0))
+    val neg   = Mux(sat, limit(w - 1, 0), (0.U - mag)(w - 1, 0))
+    Mux(isNaN, 0.U(w.W), Mux(sign, neg, pos))
+  }
+  
+  def fp32ToBF16(x: UInt): UInt = {
+    val isNaN = x(30, 23) === "hFF".U && x(22, 0) =/= 0.U
+    val rnd   = x +& "h7FFF".U +& x(16)
+    Mux(isNaN, Cat(x(31), "h7FC0".U(15.W)), rnd(31, 16))
+  }
 }
 
 object TANHFP32Utils {
@@ -47,7 +199,62 @@ object TANHFP32Utils {
 
 import TANHFP32Utils._
 
-class ADDFP32[T <: Bundle](ctrlSignals: T) extends Module {
+// len x len multiplier with the partial-product bits of the `trunc` lowest
+// columns left out. The expected value of what was dropped, a quarter per
+// bit, is added back as a constant rounded to a multiple of 2^trunc. The
+// kept bits go through a Dadda tree down to two rows, and only the columns
+// from `trunc` up need the final adder.
+class TruncMultiplier(len: Int, trunc: Int) extends Module {
+  val io = IO(new Bundle {
+    val a      = Input(UInt(len.W))
+    val b      = Input(UInt(len.W))
+    val result = Output(UInt((2 * len).W))
+  })
+  
+  val width = 2 * len - trunc
+  val comp  = BigInt((trunc + 1) / 4)
+  
+  // cols(c) holds the bits of weight 2^(trunc + c)
+  var cols: Seq[Seq[Bool]] = Seq.tabulate(width) { c =>
+    val col = c + trunc
+    val pps = for (i <- 0 until len; j = col - i if j >= 0 && j < len) yield io.a(j) && io.b(i)
+    if (comp.testBit(c)) pps :+ true.B else pps
+  }
+  
+  // Dadda stage heights 2, 3, 4, 6, 9, ... below the tallest column
+  val heights = Iterator.iterate(2)(_ * 3 / 2).takeWhile(_ < cols.map(_.length).max).toSeq
+  for (target <- heights.reverse) {
+    val carries = Array.fill(width + 1)(Seq.empty[Bool])
+    cols = Seq.tabulate(width) { c =>
+      var pending = cols(c)
+      var done    = Seq.empty[Bool]
+      var height  = pending.length + carries(c).length
+      while (height > target) {
+        if (height - target >= 2 && pending.length >= 3) {
+          val Seq(x, y, z) = pending.take(3)
+          done :+= x ^ y ^ z
+          carries(c + 1) :+= (x && y) || (x && z) || (y && z)
+          pending = pending.drop(3)
+          height -= 2
+        } else {
+          val Seq(x, y) = pending.take(2)
+          done :+= x ^ y
+          carries(c + 1) :+= x && y
+          pending = pending.drop(2)
+          height -= 1
+        }
+      }
+      done ++ pending ++ carries(c)
+    }
+  }
+  
+  // The product fits in 2 * len bits, so the final carry out is 0
+  val row0 = VecInit(cols.map(_.lift(0).getOrElse(false.B))).asUInt
+  val row1 = VecInit(cols.map(_.lift(1).getOrElse(false.B))).asUInt
+  io.result := Cat(row0 + row1, 0.U(trunc.W))
+}
+
+class ADDFP32[T <: Bundle](ctrlSignals: T, pipe: Seq[Boolean] = Seq(true, true)) extends Module {
   val expWidth  = 8
   val precision = 24
   
@@ -81,7 +288,7 @@ class ADDFP32[T <: Bundle](ctrlSignals: T) extends Module {
     val out  = addS1.io.out.cloneType
     val ctrl = ctrlSignals.cloneType.asInstanceOf[T]
   }))
-  val s1Pipe = s1.handshakePipeIf(true)
+  val s1Pipe = s1.handshakePipeIf(pipe(0))
   
   s1.valid         := io.in.valid
   s1.bits.out      := addS1.io.out
@@ -91,7 +298,7 @@ class ADDFP32[T <: Bundle](ctrlSignals: T) extends Module {
   addS2.io.in := s1Pipe.bits.out
   
   val s2     = Wire(Decoupled(new OutBundle))
-  val s2Pipe = s2.handshakePipeIf(true)
+  val s2Pipe = s2.handshakePipeIf(pipe(1))
   
   s2.valid       := s1Pipe.valid
   s2.bits.result := addS2.io.result
@@ -101,19 +308,19 @@ class ADDFP32[T <: Bundle](ctrlSignals: T) extends Module {
   io.out <> s2Pipe
 }
 
-class MULFP32[T <: Bundle](ctrlSignals: T) extends Module {
-  val expWidth  = 8
-  val precision = 24
+class MULFP32[T <: Bundle](ctrlSignals: T, pipe: Seq[Boolean] = Seq(true, true, true), trunc: Int = 0,
+                           precision: Int = 24) extends Module {
+  val expWidth = 8
   
   class InBundle extends Bundle {
-    val a    = UInt(32.W)
-    val b    = UInt(32.W)
+    val a    = UInt((expWidth + precision).W)
+    val b    = UInt((expWidth + precision).W)
     val rm   = UInt(3.W)
     val ctrl = ctrlSignals.cloneType.asInstanceOf[T]
   }
   
   class OutBundle extends Bundle {
-    val result = UInt(32.W)
+    val result = UInt((expWidth + precision).W)
     val toAdd  = new FMULToFADD(expWidth, precision)
     val ctrl   = ctrlSignals.cloneType.asInstanceOf[T]
   }
@@ -123,7 +330,6 @@ class MULFP32[T <: Bundle](ctrlSignals: T) extends Module {
     val out = Decoupled(new OutBundle)
   })
   
-  val mul   = Module(new Multiplier(precision + 1, pipeAt = Seq()))
   val mulS1 = Module(new FMUL_s1(expWidth, precision))
   val mulS2 = Module(new FMUL_s2(expWidth, precision))
   val mulS3 = Module(new FMUL_s3(expWidth, precision))
@@ -135,20 +341,29 @@ class MULFP32[T <: Bundle](ctrlSignals: T) extends Module {
   val rawA = RawFloat.fromUInt(io.in.bits.a, expWidth, precision)
   val rawB = RawFloat.fromUInt(io.in.bits.b, expWidth, precision)
   
-  mul.io.a := rawA.sig
-  mul.io.b := rawB.sig
-  mul.io.regEnables.foreach(_ := true.B)
+  val product = if (trunc == 0) {
+    val mul = Module(new Multiplier(precision + 1, pipeAt = Seq()))
+    mul.io.a := rawA.sig
+    mul.io.b := rawB.sig
+    mul.io.regEnables.foreach(_ := true.B)
+    mul.io.result
+  } else {
+    val mul = Module(new TruncMultiplier(precision + 1, trunc))
+    mul.io.a := rawA.sig
+    mul.io.b := rawB.sig
+    mul.io.result
+  }
   
   val s1 = Wire(Decoupled(new Bundle {
     val mulS1Out = mulS1.io.out.cloneType
-    val prod     = mul.io.result.cloneType
+    val prod     = chiselTypeOf(product)
     val ctrl     = ctrlSignals.cloneType.asInstanceOf[T]
   }))
-  val s1Pipe = s1.handshakePipeIf(true)
+  val s1Pipe = s1.handshakePipeIf(pipe(0))
   
   s1.valid         := io.in.valid
   s1.bits.mulS1Out := mulS1.io.out
-  s1.bits.prod     := mul.io.result
+  s1.bits.prod     := product
   s1.bits.ctrl     := io.in.bits.ctrl
   io.in.ready      := s1.ready
   
@@ -159,7 +374,7 @@ class MULFP32[T <: Bundle](ctrlSignals: T) extends Module {
     val mulS2Out = mulS2.io.out.cloneType
     val ctrl     = ctrlSignals.cloneType.asInstanceOf[T]
   }))
-  val s2Pipe = s2.handshakePipeIf(true)
+  val s2Pipe = s2.handshakePipeIf(pipe(1))
   
   s2.valid         := s1Pipe.valid
   s2.bits.mulS2Out := mulS2.io.out
@@ -169,7 +384,7 @@ class MULFP32[T <: Bundle](ctrlSignals: T) extends Module {
   mulS3.io.in := s2Pipe.bits.mulS2Out
   
   val s3     = Wire(Decoupled(new OutBundle))
-  val s3Pipe = s3.handshakePipeIf(true)
+  val s3Pipe = s3.handshakePipeIf(pipe(2))
   
   s3.valid          := s2Pipe.valid
   s3.bits.result    := mulS3.io.result
@@ -180,20 +395,23 @@ class MULFP32[T <: Bundle](ctrlSignals: T) extends Module {
   io.out <> s3Pipe
 }
 
-class CMAFP32[T <: Bundle](ctrlSignals: T) extends Module {
+// a and c are FP32; b and the result carry inPc and outPc significand bits,
+// wider than 24 when the accumulator is forwarded between CMAs
+class CMAFP32[T <: Bundle](ctrlSignals: T, config: TANHFP32Config = TANHFP32Config(),
+                           inPc: Int = 24, outPc: Int = 24) extends Module {
   val expWidth  = 8
   val precision = 24
   
   class InBundle extends Bundle {
     val a    = UInt(32.W)
-    val b    = UInt(32.W)
+    val b    = UInt((expWidth + inPc).W)
     val c    = UInt(32.W)
     val rm   = UInt(3.W)
     val ctrl = ctrlSignals.cloneType.asInstanceOf[T]
   }
   
   class OutBundle extends Bundle {
-    val result = UInt(32.W)
+    val result = UInt((expWidth + outPc).W)
     val ctrl   = ctrlSignals.cloneType.asInstanceOf[T]
   }
   
@@ -207,58 +425,87 @@ class CMAFP32[T <: Bundle](ctrlSignals: T) extends Module {
     val topCtrl = ctrlSignals.cloneType.asInstanceOf[T]
   }
   
-  val mul   = Module(new MULFP32[MULToADD](new MULToADD))
-  val addS1 = Module(new FCMA_ADD_s1(expWidth, precision * 2, precision))
-  val addS2 = Module(new FCMA_ADD_s2(expWidth, precision * 2, precision))
+  val mul = Module(new MULFP32[MULToADD](new MULToADD, config.pipe.mul, config.mulTrunc, inPc))
   
+  // Zero-extending the significand widens a float exactly
   mul.io.in.valid             := io.in.valid
-  mul.io.in.bits.a            := io.in.bits.a
+  mul.io.in.bits.a            := Cat(io.in.bits.a, 0.U((inPc - precision).W))
   mul.io.in.bits.b            := io.in.bits.b
   mul.io.in.bits.rm           := io.in.bits.rm
   mul.io.in.bits.ctrl.c       := io.in.bits.c
   mul.io.in.bits.ctrl.topCtrl := io.in.bits.ctrl
   io.in.ready                 := mul.io.in.ready
   
-  addS1.io.a             := Cat(mul.io.out.bits.ctrl.c, 0.U(precision.W))
-  addS1.io.b             := mul.io.out.bits.toAdd.fp_prod.asUInt
-  addS1.io.b_inter_valid := true.B
-  addS1.io.b_inter_flags := mul.io.out.bits.toAdd.inter_flags
-  addS1.io.rm            := mul.io.out.bits.toAdd.rm
-  
-  val s4 = Wire(Decoupled(new Bundle {
-    val out  = addS1.io.out.cloneType
-    val ctrl = ctrlSignals.cloneType.asInstanceOf[T]
-  }))
-  val s4Pipe = s4.handshakePipeIf(true)
-  
-  s4.valid         := mul.io.out.valid
-  s4.bits.out      := addS1.io.out
-  s4.bits.ctrl     := mul.io.out.bits.ctrl.topCtrl
-  mul.io.out.ready := s4.ready
-  
-  addS2.io.in := s4Pipe.bits.out
-  
-  val s5     = Wire(Decoupled(new OutBundle))
-  val s5Pipe = s5.handshakePipeIf(true)
-  
-  s5.valid       := s4Pipe.valid
-  s5.bits.result := addS2.io.result
-  s5.bits.ctrl   := s4Pipe.bits.ctrl
-  s4Pipe.ready   := s5.ready
-  
-  io.out <> s5Pipe
+  if (config.engine == "fma") {
+    // A narrower adder takes the top addWidth product bits, with the rest
+    // ORed into the lowest one as a sticky bit. A forwarded operand always
+    // gets the exact adder, which rounds once to outPc bits. FCMA_ADD_s1
+    // takes its b significand as the 2p-1 bit product sig (io.a/io.b are
+    // 8 + 48 bits in rtl/TANHFP32.sv), and FMUL_s3 clears fp_prod for a zero
+    // operand, so the TruncMultiplier constant never reaches the adder.
+    val addWidth = if (inPc == precision) config.addWidth else inPc * 2
+    val addS1    = Module(new FCMA_ADD_s1(expWidth, addWidth, outPc))
+    val addS2    = Module(new FCMA_ADD_s2(expWidth, addWidth, outPc))
+    val fpProd   = mul.io.out.bits.toAdd.fp_prod
+    val prodB    = if (addWidth == inPc * 2) fpProd.asUInt else {
+      val drop = inPc * 2 - addWidth
+      Cat(fpProd.sign, fpProd.exp, fpProd.sig.head(addWidth - 1) | fpProd.sig(drop - 1, 0).orR)
+    }
+    
+    addS1.io.a             := Cat(mul.io.out.bits.ctrl.c, 0.U((addWidth - precision).W))
+    addS1.io.b             := prodB
+    addS1.io.b_inter_valid := true.B
+    addS1.io.b_inter_flags := mul.io.out.bits.toAdd.inter_flags
+    addS1.io.rm            := mul.io.out.bits.toAdd.rm
+    
+    val s4 = Wire(Decoupled(new Bundle {
+      val out  = addS1.io.out.cloneType
+      val ctrl = ctrlSignals.cloneType.asInstanceOf[T]
+    }))
+    val s4Pipe = s4.handshakePipeIf(config.pipe.add(0))
+    
+    s4.valid         := mul.io.out.valid
+    s4.bits.out      := addS1.io.out
+    s4.bits.ctrl     := mul.io.out.bits.ctrl.topCtrl
+    mul.io.out.ready := s4.ready
+    
+    addS2.io.in := s4Pipe.bits.out
+    
+    val s5     = Wire(Decoupled(new OutBundle))
+    val s5Pipe = s5.handshakePipeIf(config.pipe.add(1))
+    
+    s5.valid       := s4Pipe.valid
+    s5.bits.result := addS2.io.result
+    s5.bits.ctrl   := s4Pipe.bits.ctrl
+    s4Pipe.ready   := s5.ready
+    
+    io.out <> s5Pipe
+  } else {
+    // Rounded product into a separate adder: cheaper, two roundings
+    val add = Module(new ADDFP32[T](ctrlSignals, config.pipe.add))
+    
+    add.io.in.valid     := mul.io.out.valid
+    add.io.in.bits.a    := mul.io.out.bits.ctrl.c
+    add.io.in.bits.b    := mul.io.out.bits.result
+    add.io.in.bits.rm   := mul.io.out.bits.toAdd.rm
+    add.io.in.bits.ctrl := mul.io.out.bits.ctrl.topCtrl
+    mul.io.out.ready    := add.io.in.ready
+    
+    io.out.valid       := add.io.out.valid
+    io.out.bits.result := add.io.out.bits.result
+    io.out.bits.ctrl   := add.io.out.bits.ctrl
+    add.io.out.ready   := io.out.ready
+  }
 }
 
-class LUTTanh[T <: Bundle](ctrlSignals: T) extends Module {
+class LUTTanh[T <: Bundle](ctrlSignals: T, config: TANHFP32Config = TANHFP32Config()) extends Module {
   class InBundle extends Bundle {
-    val index = UInt(6.W)
+    val index = UInt(config.indexWidth.W)
     val ctrl  = ctrlSignals.cloneType.asInstanceOf[T]
   }
   
   class OutBundle extends Bundle {
-    val c0   = UInt(32.W)
-    val c1   = UInt(32.W)
-    val c2   = UInt(32.W)
+    val c    = Vec(config.degree + 1, UInt(32.W))
     val ctrl = ctrlSignals.cloneType.asInstanceOf[T]
   }
   
@@ -267,26 +514,28 @@ class LUTTanh[T <: Bundle](ctrlSignals: T) extends Module {
     val out = Decoupled(new OutBundle)
   })
   
-  val lut = TANHFP32Parameters.loadLUT("lut.txt")
+  val lut = TANHFP32Parameters.loadLUT(config.lutFile)
+  require(lut.length == config.regions && lut.forall(_._2.length == config.degree + 1),
+    s"${config.lutFile} must have ${config.regions} entries of ${config.degree + 1} coefficients")
   
-  val c0Table = VecInit(lut.map { case (_, c0, _, _) => c0.U(32.W) })
-  val c1Table = VecInit(lut.map { case (_, _, c1, _) => c1.U(32.W) })
-  val c2Table = VecInit(lut.map { case (_, _, _, c2) => c2.U(32.W) })
+  val cTables = Seq.tabulate(config.degree + 1) { k =>
+    VecInit(lut.map { case (_, c) => c(k).U(32.W) })
+  }
   
   val s1     = Wire(Decoupled(new OutBundle))
-  val s1Pipe = s1.handshakePipeIf(true)
+  val s1Pipe = s1.handshakePipeIf(config.pipe.lut)
   
   s1.valid     := io.in.valid
-  s1.bits.c0   := c0Table(io.in.bits.index)
-  s1.bits.c1   := c1Table(io.in.bits.index)
-  s1.bits.c2   := c2Table(io.in.bits.index)
+  for (k <- 0 to config.degree) {
+    s1.bits.c(k) := cTables(k)(io.in.bits.index)
+  }
   s1.bits.ctrl := io.in.bits.ctrl
   
   io.in.ready := s1.ready
   io.out <> s1Pipe
 }
 
-class FilterTanhFP32[T <: Bundle](ctrlSignals: T) extends Module {
+class FilterTanhFP32[T <: Bundle](ctrlSignals: T, config: TANHFP32Config = TANHFP32Config()) extends Module {
   class InBundle extends Bundle {
     val in   = UInt(32.W)
     val ctrl = ctrlSignals.cloneType.asInstanceOf[T]
@@ -342,11 +591,19 @@ class FilterTanhFP32[T <: Bundle](ctrlSignals: T) extends Module {
     rangeVal := Mux(sign, TANHFP32Parameters.NEG_ONE, TANHFP32Parameters.ONE)
   }
   
-  val bypass    = specialBypass || rangeBypass
-  val bypassVal = Mux(specialBypass, specialVal, rangeVal)
+  // Fix-up CAM: every key compared with |x| at once. Keys lie inside the
+  // polynomial domain, so a hit never overlaps the other bypasses.
+  val fixups  = config.fixupFile.map(TANHFP32Parameters.loadFixups).getOrElse(Seq.empty)
+  val fixHits = fixups.map { case (in, _) => xAbs === in.U(32.W) }
+  val fixHit  = fixHits.foldLeft(false.B)(_ || _)
+  val fixVal  = if (fixups.isEmpty) 0.U(32.W)
+                else Cat(sign, Mux1H(fixHits, fixups.map { case (_, out) => out.U(31.W) }))
+  
+  val bypass    = specialBypass || rangeBypass || fixHit
+  val bypassVal = Mux(specialBypass, specialVal, Mux(rangeBypass, rangeVal, fixVal))
   
   val s1     = Wire(Decoupled(new OutBundle))
-  val s1Pipe = s1.handshakePipeIf(true)
+  val s1Pipe = s1.handshakePipeIf(config.pipe.filter)
   
   s1.valid          := io.in.valid
   s1.bits.out       := io.in.bits.in
@@ -362,7 +619,7 @@ class FilterTanhFP32[T <: Bundle](ctrlSignals: T) extends Module {
   io.out <> s1Pipe
 }
 
-class SegmentIndexFP32[T <: Bundle](ctrlSignals: T) extends Module {
+class SegmentIndexFP32[T <: Bundle](ctrlSignals: T, config: TANHFP32Config = TANHFP32Config()) extends Module {
   class InBundle extends Bundle {
     val expField = UInt(8.W)
     val frac     = UInt(23.W)
@@ -371,7 +628,7 @@ class SegmentIndexFP32[T <: Bundle](ctrlSignals: T) extends Module {
   }
   
   class OutBundle extends Bundle {
-    val region = UInt(6.W)
+    val region = UInt(config.indexWidth.W)
     val xAbs   = UInt(32.W)
     val ctrl   = ctrlSignals.cloneType.asInstanceOf[T]
   }
@@ -383,11 +640,11 @@ class SegmentIndexFP32[T <: Bundle](ctrlSignals: T) extends Module {
   
   val e_unbias = io.in.bits.expField.zext - 127.S
   val e_off    = (e_unbias + 5.S).asUInt
-  val m_hi3    = io.in.bits.frac(22, 20)
-  val region   = Cat(e_off(2, 0), m_hi3)
+  val region   = if (config.segBits == 0) e_off(2, 0)
+                 else Cat(e_off(2, 0), io.in.bits.frac(22, 23 - config.segBits))
   
   val s1     = Wire(Decoupled(new OutBundle))
-  val s1Pipe = s1.handshakePipeIf(true)
+  val s1Pipe = s1.handshakePipeIf(config.pipe.segment)
   
   s1.valid       := io.in.valid
   s1.bits.region := region
@@ -398,40 +655,56 @@ class SegmentIndexFP32[T <: Bundle](ctrlSignals: T) extends Module {
   io.out <> s1Pipe
 }
 
-class TANHFP32 extends Module {
-  class InBundle extends Bundle {
-    val in = UInt(32.W)
-    val rm = UInt(3.W)
-  }
-  
+// One transaction at the TANHFP32 input
+class TANHFP32In(config: TANHFP32Config) extends Bundle {
+  val in      = UInt(config.inWidth.W)
+  val rm      = UInt(3.W)
+  val inFrac  = Option.when(config.inFracWidth > 0)(UInt(config.inFracWidth.W))
+  val outFrac = Option.when(config.outFracWidth > 0)(UInt(config.outFracWidth.W))
+  val tag     = Option.when(config.tagWidth > 0)(UInt(config.tagWidth.W))
+}
+
+class TANHFP32(config: TANHFP32Config = TANHFP32Config()) extends Module {
   class OutBundle extends Bundle {
-    val out = UInt(32.W)
+    val out = UInt(config.outWidth.W)
+    val tag = Option.when(config.tagWidth > 0)(UInt(config.tagWidth.W))
   }
   
   val io = IO(new Bundle {
-    val in  = Flipped(Decoupled(new InBundle))
+    val in  = Flipped(Decoupled(new TANHFP32In(config)))
     val out = Decoupled(new OutBundle)
   })
   
+  // outFrac and tag travel with the data; zero width unless the output is an
+  // integer or the instance is tagged
   class FilterToSegment extends Bundle {
-    val rm = UInt(3.W)
+    val rm      = UInt(3.W)
+    val outFrac = UInt(config.outFracWidth.W)
+    val tag     = UInt(config.tagWidth.W)
   }
   
-  val filter = Module(new FilterTanhFP32[FilterToSegment](new FilterToSegment))
+  val filter = Module(new FilterTanhFP32[FilterToSegment](new FilterToSegment, config))
+  
+  val xIn = if (config.inFormat == "fp32") io.in.bits.in
+            else TANHFP32Format.fixedToFP32(io.in.bits.in, io.in.bits.inFrac.get)
   
-  io.in.ready               := filter.io.in.ready
-  filter.io.in.valid        := io.in.valid
-  filter.io.in.bits.in      := io.in.bits.in
-  filter.io.in.bits.ctrl.rm := io.in.bits.rm
+  io.in.ready                    := filter.io.in.ready
+  filter.io.in.valid             := io.in.valid
+  filter.io.in.bits.in           := xIn
+  filter.io.in.bits.ctrl.rm      := io.in.bits.rm
+  filter.io.in.bits.ctrl.outFrac := io.in.bits.outFrac.getOrElse(0.U(0.W))
+  filter.io.in.bits.ctrl.tag     := io.in.bits.tag.getOrElse(0.U(0.W))
   
   class SegmentToLUT extends Bundle {
     val rm        = UInt(3.W)
+    val outFrac   = UInt(config.outFracWidth.W)
+    val tag       = UInt(config.tagWidth.W)
     val bypass    = Bool()
     val bypassVal = UInt(32.W)
     val sign      = Bool()
   }
   
-  val segment = Module(new SegmentIndexFP32[SegmentToLUT](new SegmentToLUT))
+  val segment = Module(new SegmentIndexFP32[SegmentToLUT](new SegmentToLUT, config))
   
   filter.io.out.ready                 := segment.io.in.ready
   segment.io.in.valid                 := filter.io.out.valid
@@ -439,93 +712,392 @@ class TANHFP32 extends Module {
   segment.io.in.bits.frac             := filter.io.out.bits.frac
   segment.io.in.bits.xAbs             := filter.io.out.bits.xAbs
   segment.io.in.bits.ctrl.rm          := filter.io.out.bits.ctrl.rm
+  segment.io.in.bits.ctrl.outFrac     := filter.io.out.bits.ctrl.outFrac
+  segment.io.in.bits.ctrl.tag         := filter.io.out.bits.ctrl.tag
   segment.io.in.bits.ctrl.bypass      := filter.io.out.bits.bypass
   segment.io.in.bits.ctrl.bypassVal   := filter.io.out.bits.bypassVal
   segment.io.in.bits.ctrl.sign        := filter.io.out.bits.sign
   
   class LUTToCma0 extends Bundle {
     val rm        = UInt(3.W)
+    val outFrac   = UInt(config.outFracWidth.W)
+    val tag       = UInt(config.tagWidth.W)
     val bypass    = Bool()
     val bypassVal = UInt(32.W)
     val sign      = Bool()
     val xAbs      = UInt(32.W)
   }
   
-  val lut = Module(new LUTTanh[LUTToCma0](new LUTToCma0))
+  val lut = Module(new LUTTanh[LUTToCma0](new LUTToCma0, config))
   
   segment.io.out.ready          := lut.io.in.ready
   lut.io.in.valid               := segment.io.out.valid
   lut.io.in.bits.index          := segment.io.out.bits.region
   lut.io.in.bits.ctrl.rm        := segment.io.out.bits.ctrl.rm
+  lut.io.in.bits.ctrl.outFrac   := segment.io.out.bits.ctrl.outFrac
+  lut.io.in.bits.ctrl.tag       := segment.io.out.bits.ctrl.tag
   lut.io.in.bits.ctrl.bypass    := segment.io.out.bits.ctrl.bypass
   lut.io.in.bits.ctrl.bypassVal := segment.io.out.bits.ctrl.bypassVal
   lut.io.in.bits.ctrl.sign      := segment.io.out.bits.ctrl.sign
   lut.io.in.bits.ctrl.xAbs      := segment.io.out.bits.xAbs
   
-  class Cma0ToCma1 extends Bundle {
+  // Horner: acc = c<degree>, then acc = xAbs * acc + c<k> per CMA. Each CMA
+  // carries the coefficients still to be added (c0 .. c<k-1>) in its ctrl.
+  // acc travels between CMAs with fwdWidth significand bits and is rounded
+  // to FP32 only by the last one. It still goes through both adder stages:
+  // FCMA_ADD_s1 hands over the far-path operands before their carry-propagate
+  // add and the near-path difference before its normalizing shift, so the sum
+  // first exists inside FCMA_ADD_s2, next to the rounder.
+  class CmaCtrl(nCoeffs: Int) extends Bundle {
     val rm        = UInt(3.W)
+    val outFrac   = UInt(config.outFracWidth.W)
+    val tag       = UInt(config.tagWidth.W)
     val bypass    = Bool()
     val bypassVal = UInt(32.W)
     val sign      = Bool()
-    val c0        = UInt(32.W)
+    val c         = Vec(nCoeffs, UInt(32.W))
     val xAbs      = UInt(32.W)
   }
   
-  val cma0 = Module(new CMAFP32[Cma0ToCma1](new Cma0ToCma1))
+  val cmas = Seq.tabulate(config.degree) { i =>
+    val k     = config.degree - 1 - i
+    val inPc  = if (i == 0) 24 else config.fwdWidth
+    val outPc = if (k == 0) 24 else config.fwdWidth
+    Module(new CMAFP32[CmaCtrl](new CmaCtrl(k), config, inPc, outPc)).suggestName(s"cma$i")
+  }
   
+  val cma0 = cmas.head
   lut.io.out.ready               := cma0.io.in.ready
   cma0.io.in.valid               := lut.io.out.valid
   cma0.io.in.bits.a              := lut.io.out.bits.ctrl.xAbs
-  cma0.io.in.bits.b              := lut.io.out.bits.c2
-  cma0.io.in.bits.c              := lut.io.out.bits.c1
+  cma0.io.in.bits.b              := lut.io.out.bits.c(config.degree)
+  cma0.io.in.bits.c              := lut.io.out.bits.c(config.degree - 1)
   cma0.io.in.bits.rm             := lut.io.out.bits.ctrl.rm
   cma0.io.in.bits.ctrl.rm        := lut.io.out.bits.ctrl.rm
+  cma0.io.in.bits.ctrl.outFrac   := lut.io.out.bits.ctrl.outFrac
+  cma0.io.in.bits.ctrl.tag       := lut.io.out.bits.ctrl.tag
   cma0.io.in.bits.ctrl.bypass    := lut.io.out.bits.ctrl.bypass
   cma0.io.in.bits.ctrl.bypassVal := lut.io.out.bits.ctrl.bypassVal
   cma0.io.in.bits.ctrl.sign      := lut.io.out.bits.ctrl.sign
-  cma0.io.in.bits.ctrl.c0        := lut.io.out.bits.c0
   cma0.io.in.bits.ctrl.xAbs      := lut.io.out.bits.ctrl.xAbs
-  
-  class Cma1ToMux extends Bundle {
-    val bypass    = Bool()
-    val bypassVal = UInt(32.W)
-    val sign      = Bool()
+  for (j <- 0 until config.degree - 1) {
+    cma0.io.in.bits.ctrl.c(j) := lut.io.out.bits.c(j)
   }
   
-  val cma1 = Module(new CMAFP32[Cma1ToMux](new Cma1ToMux))
+  for (Seq(prev, next) <- cmas.sliding(2)) {
+    val k = next.io.in.bits.ctrl.c.length
+    prev.io.out.ready              := next.io.in.ready
+    next.io.in.valid               := prev.io.out.valid
+    next.io.in.bits.a              := prev.io.out.bits.ctrl.xAbs
+    next.io.in.bits.b              := prev.io.out.bits.result
+    next.io.in.bits.c              := prev.io.out.bits.ctrl.c(k)
+    next.io.in.bits.rm             := prev.io.out.bits.ctrl.rm
+    next.io.in.bits.ctrl.rm        := prev.io.out.bits.ctrl.rm
+    next.io.in.bits.ctrl.outFrac   := prev.io.out.bits.ctrl.outFrac
+    next.io.in.bits.ctrl.tag       := prev.io.out.bits.ctrl.tag
+    next.io.in.bits.ctrl.bypass    := prev.io.out.bits.ctrl.bypass
+    next.io.in.bits.ctrl.bypassVal := prev.io.out.bits.ctrl.bypassVal
+    next.io.in.bits.ctrl.sign      := prev.io.out.bits.ctrl.sign
+    next.io.in.bits.ctrl.xAbs      := prev.io.out.bits.ctrl.xAbs
+    for (j <- 0 until k) {
+      next.io.in.bits.ctrl.c(j) := prev.io.out.bits.ctrl.c(j)
+    }
+  }
   
-  cma0.io.out.ready               := cma1.io.in.ready
-  cma1.io.in.valid                := cma0.io.out.valid
-  cma1.io.in.bits.a               := cma0.io.out.bits.ctrl.xAbs
-  cma1.io.in.bits.b               := cma0.io.out.bits.result
-  cma1.io.in.bits.c               := cma0.io.out.bits.ctrl.c0
-  cma1.io.in.bits.rm              := cma0.io.out.bits.ctrl.rm
-  cma1.io.in.bits.ctrl.bypass     := cma0.io.out.bits.ctrl.bypass
-  cma1.io.in.bits.ctrl.bypassVal  := cma0.io.out.bits.ctrl.bypassVal
-  cma1.io.in.bits.ctrl.sign       := cma0.io.out.bits.ctrl.sign
+  val cmaLast = cmas.last
   
-  val ySigned = Mux(cma1.io.out.bits.ctrl.sign, 
-                    Cat(1.U(1.W), cma1.io.out.bits.result(30, 0)), 
-                    cma1.io.out.bits.result)
+  val ySigned = Mux(cmaLast.io.out.bits.ctrl.sign, 
+                    Cat(1.U(1.W), cmaLast.io.out.bits.result(30, 0)), 
+                    cmaLast.io.out.bits.result)
   
-  val finalResult = Mux(cma1.io.out.bits.ctrl.bypass, 
-                        cma1.io.out.bits.ctrl.bypassVal, 
+  val finalResult = Mux(cmaLast.io.out.bits.ctrl.bypass, 
+                        cmaLast.io.out.bits.ctrl.bypassVal, 
                         ySigned)
   
+  // Quantized outputs are rounded once, straight from the FP32 result
+  val yOut = config.outFormat match {
+    case "fp32" => finalResult
+    case "bf16" => TANHFP32Format.fp32ToBF16(finalResult)
+    case _      => TANHFP32Format.fp32ToFixed(finalResult, cmaLast.io.out.bits.ctrl.outFrac, config.outWidth)
+  }
+  
   val sOut     = Wire(Decoupled(new OutBundle))
-  val sOutPipe = sOut.handshakePipeIf(true)
+  val sOutPipe = sOut.handshakePipeIf(config.pipe.out)
   
-  sOut.valid       := cma1.io.out.valid
-  sOut.bits.out    := finalResult
-  cma1.io.out.ready := sOut.ready
+  sOut.valid       := cmaLast.io.out.valid
+  sOut.bits.out    := yOut
+  sOut.bits.tag.foreach(_ := cmaLast.io.out.bits.ctrl.tag)
+  cmaLast.io.out.ready := sOut.ready
   
   io.out <> sOutPipe
 }
 
+// Dual-clock FIFO: Gray-coded pointers, each crossing through two flops. The
+// storage is written in the enq domain and read asynchronously by deq, which
+// only reads entries whose write it has seen through the synchronizer.
+class AsyncFIFO[T <: Data](gen: T, depth: Int = 8) extends RawModule {
+  require(isPow2(depth) && depth >= 2, s"depth $depth must be a power of 2 >= 2")
+  val aw = log2Ceil(depth)
+  
+  val io = IO(new Bundle {
+    val enqClock = Input(Clock())
+    val enqReset = Input(Bool())
+    val enq      = Flipped(Decoupled(gen))
+    val deqClock = Input(Clock())
+    val deqReset = Input(Bool())
+    val deq      = Decoupled(gen)
+  })
+  
+  def toGray(bin: UInt): UInt = bin ^ (bin >> 1)
+  
+  val wGray = Wire(UInt((aw + 1).W))
+  val rGray = Wire(UInt((aw + 1).W))
+  val mem   = withClock(io.enqClock) { Reg(Vec(depth, gen)) }
+  
+  withClockAndReset(io.enqClock, io.enqReset) {
+    val bin   = RegInit(0.U((aw + 1).W))
+    val gray  = RegInit(0.U((aw + 1).W))
+    val rSync = RegNext(RegNext(rGray, 0.U), 0.U).suggestName("rGraySync")
+    // Full: the write pointer is one lap ahead, top two Gray bits inverted
+    io.enq.ready := gray =/= (rSync ^ ("b11".U << (aw - 1)))
+    when (io.enq.fire) {
+      mem(bin(aw - 1, 0)) := io.enq.bits
+    }
+    val next = bin + io.enq.fire
+    bin   := next
+    gray  := toGray(next)
+    wGray := gray
+  }
+  
+  withClockAndReset(io.deqClock, io.deqReset) {
+    val bin   = RegInit(0.U((aw + 1).W))
+    val gray  = RegInit(0.U((aw + 1).W))
+    val wSync = RegNext(RegNext(wGray, 0.U), 0.U).suggestName("wGraySync")
+    io.deq.valid := gray =/= wSync
+    io.deq.bits  := mem(bin(aw - 1, 0))
+    val next = bin + io.deq.fire
+    bin   := next
+    gray  := toGray(next)
+    rGray := gray
+  }
+}
+
+// TANHFP32 in its own clock domain behind async FIFOs. The fabric side moves
+// `lanes` transactions per fabric cycle; the core takes one per core cycle, so
+// a core clock `lanes` times the fabric clock keeps up with it.
+class TANHFP32CDC(config: TANHFP32Config = TANHFP32Config(), lanes: Int = 2, fifoDepth: Int = 8)
+    extends RawModule {
+  require(lanes >= 1, s"lanes $lanes must be at least 1")
+  
+  val fabricClock = IO(Input(Clock()))
+  val fabricReset = IO(Input(Bool()))
+  val coreClock   = IO(Input(Clock()))
+  val coreReset   = IO(Input(Bool()))
+  val io = IO(new Bundle {
+    val in  = Flipped(Decoupled(Vec(lanes, new TANHFP32In(config))))
+    val out = Decoupled(Vec(lanes, UInt(config.outWidth.W)))
+  })
+  
+  val inFifo  = Module(new AsyncFIFO(Vec(lanes, new TANHFP32In(config)), fifoDepth))
+  val outFifo = Module(new AsyncFIFO(Vec(lanes, UInt(config.outWidth.W)), fifoDepth))
+  
+  inFifo.io.enqClock  := fabricClock
+  inFifo.io.enqReset  := fabricReset
+  inFifo.io.enq       <> io.in
+  inFifo.io.deqClock  := coreClock
+  inFifo.io.deqReset  := coreReset
+  outFifo.io.enqClock := coreClock
+  outFifo.io.enqReset := coreReset
+  outFifo.io.deqClock := fabricClock
+  outFifo.io.deqReset := fabricReset
+  io.out              <> outFifo.io.deq
+  
+  withClockAndReset(coreClock, coreReset) {
+    val core = Module(new TANHFP32(config))
+    
+    // Issue the lanes of a fabric word one per core cycle
+    val issueLane = RegInit(0.U(log2Up(lanes).W))
+    val issueLast = issueLane === (lanes - 1).U
+    core.io.in.valid     := inFifo.io.deq.valid
+    core.io.in.bits      := inFifo.io.deq.bits(issueLane)
+    inFifo.io.deq.ready  := core.io.in.ready && issueLast
+    when (core.io.in.fire) {
+      issueLane := Mux(issueLast, 0.U, issueLane + 1.U)
+    }
+    
+    // Collect results back into a fabric word; a full word leaves the same
+    // cycle the next result arrives, so the core is never held off by it
+    val collected = Reg(Vec(lanes, UInt(config.outWidth.W)))
+    val count     = RegInit(0.U(log2Ceil(lanes + 1).W))
+    val full      = count === lanes.U
+    outFifo.io.enq.valid := full
+    outFifo.io.enq.bits  := collected
+    core.io.out.ready    := !full || outFifo.io.enq.ready
+    val slot = Mux(full, 0.U, count)
+    for (i <- 0 until lanes) {
+      when (core.io.out.fire && slot === i.U) {
+        collected(i) := core.io.out.bits.out
+      }
+    }
+    count := Mux(outFifo.io.enq.fire, 0.U, count) + core.io.out.fire
+  }
+}
+
+// Weighted round robin over `weights.length` requesters. The port holding the
+// turn keeps the grant for up to its weight in consecutive transfers, then
+// the turn passes to the next requester in order; idle ports are skipped, so
+// the arbiter is work-conserving. All-ones weights give plain round robin.
+class WRRArbiter(weights: Seq[Int]) extends Module {
+  val n = weights.length
+  require(n >= 2, s"$n requesters, need at least 2")
+  require(weights.forall(w => w >= 1 && w <= 255), s"weights $weights out of range 1..255")
+  
+  val io = IO(new Bundle {
+    val req   = Input(Vec(n, Bool()))
+    val fire  = Input(Bool())
+    val valid = Output(Bool())
+    val grant = Output(UInt(log2Up(n).W))
+  })
+  
+  val turn   = RegInit(0.U(log2Up(n).W))
+  val used   = RegInit(0.U(8.W))
+  val weight = VecInit(weights.map(_.U(8.W)))
+  
+  // First requester at or after the turn, wrapping around
+  val req     = io.req.asUInt
+  val atOrAft = req & ~((UIntToOH(turn, n) - 1.U)(n - 1, 0))
+  io.valid := req.orR
+  io.grant := Mux(atOrAft.orR, PriorityEncoder(atOrAft), PriorityEncoder(req))
+  
+  // used counts the transfers of the port holding the turn
+  when (io.fire) {
+    val count  = Mux(io.grant === turn, used, 0.U) + 1.U
+    val spent  = count === weight(io.grant)
+    val wrap   = io.grant === (n - 1).U
+    turn := Mux(spent, Mux(wrap, 0.U, io.grant + 1.U), io.grant)
+    used := Mux(spent, 0.U, count)
+  }
+}
+
+// One TANHFP32 shared by `ports` requesters. Requests are arbitrated by
+// WRRArbiter and tagged with their port, the tag rides through the core's
+// ctrl bundles, and results are steered back by tag into per-port response
+// queues. A port is only granted while it holds a credit, i.e. a free slot
+// in its queue counting results still in flight, so a stalled requester
+// never blocks the core or the other ports.
+class TANHFP32Shared(config: TANHFP32Config = TANHFP32Config(), weights: Seq[Int] = Seq(1, 1),
+                     respDepth: Int = 0) extends Module {
+  val ports = weights.length
+  val depth = if (respDepth > 0) respDepth else config.pipe.latency(config.degree) + 1
+  
+  val io = IO(new Bundle {
+    val in  = Vec(ports, Flipped(Decoupled(new TANHFP32In(config))))
+    val out = Vec(ports, Decoupled(UInt(config.outWidth.W)))
+  })
+  
+  val core    = Module(new TANHFP32(config.copy(tagWidth = log2Up(ports))))
+  val arbiter = Module(new WRRArbiter(weights))
+  val queues  = Seq.fill(ports)(Module(new Queue(UInt(config.outWidth.W), depth)))
+  val credits = RegInit(VecInit(Seq.fill(ports)(depth.U(log2Ceil(depth + 1).W))))
+  
+  val grant = arbiter.io.grant
+  val sel   = VecInit(io.in.map(_.bits))(grant)
+  arbiter.io.req  := VecInit(io.in.zip(credits).map { case (p, c) => p.valid && c =/= 0.U })
+  arbiter.io.fire := core.io.in.fire
+  
+  core.io.in.valid        := arbiter.io.valid
+  core.io.in.bits.in      := sel.in
+  core.io.in.bits.rm      := sel.rm
+  core.io.in.bits.inFrac.foreach(_ := sel.inFrac.get)
+  core.io.in.bits.outFrac.foreach(_ := sel.outFrac.get)
+  core.io.in.bits.tag.get := grant
+  for (i <- 0 until ports) {
+    io.in(i).ready := core.io.in.ready && arbiter.io.valid && grant === i.U
+  }
+  
+  // Credits guarantee the queue has room, so the core is never stalled here
+  val tag = core.io.out.bits.tag.get
+  core.io.out.ready := VecInit(queues.map(_.io.enq.ready))(tag)
+  for (i <- 0 until ports) {
+    queues(i).io.enq.valid := core.io.out.valid && tag === i.U
+    queues(i).io.enq.bits  := core.io.out.bits.out
+    io.out(i)              <> queues(i).io.deq
+    credits(i) := credits(i) - io.in(i).fire + queues(i).io.deq.fire
+  }
+}
+
 object TANHFP32Gen extends App {
+  val usage = """Usage: TANHFP32Gen [options]
+    |  --seg-bits N      Mantissa bits of the LUT index (default: 3)
+    |  --degree N        Polynomial degree (default: 2)
+    |  --engine E        fma or muladd (default: fma)
+    |  --pipe FLAGS      9 flags for filter, segment, lut, mul s1-s3, add s1-s2,
+    |                    out (default: 111111111)
+    |  --mul-trunc N     Product columns dropped by the multiplier (default: 0)
+    |  --add-width N     Product bits into the FMA adder, 26..48 (default: 48)
+    |  --fwd-width N     Significand bits forwarded between CMAs, 24..29
+    |                    (default: 24, rounded to FP32)
+    |  --in-format F     fp32, int8 or int16 (default: fp32)
+    |  --out-format F    fp32, bf16, int8 or int16 (default: fp32)
+    |  --lut FILE        Coefficient file (default: lut.txt)
+    |  --fixup FILE      Fix-up table from TANHFP32_ulpsweep --fixup-out
+    |  --tag-width N     Bits of a request tag returned with each result, 0..8
+    |                    (default: 0, no tag ports)
+    |  --cdc LANES       Emit TANHFP32CDC with LANES fabric lanes instead
+    |  --shared PORTS    Emit TANHFP32Shared with PORTS requesters instead
+    |  --weights LIST    Arbiter weights per port, e.g. 2,1,1,1 (default: all 1)
+    |  --resp-depth N    Response queue entries per port (default: latency + 1)
+    |  --target-dir DIR  Output directory (default: rtl)""".stripMargin
+  
+  case class Options(config: TANHFP32Config = TANHFP32Config(), targetDir: String = "rtl",
+                     cdcLanes: Option[Int] = None, sharedPorts: Option[Int] = None,
+                     weights: Option[Seq[Int]] = None, respDepth: Int = 0)
+  
+  def parse(rem: List[String], o: Options): Options = {
+    def cfg(c: TANHFP32Config) = o.copy(config = c)
+    rem match {
+      case Nil                          => o
+      case "--seg-bits" :: v :: rest    => parse(rest, cfg(o.config.copy(segBits = v.toInt)))
+      case "--degree" :: v :: rest      => parse(rest, cfg(o.config.copy(degree = v.toInt)))
+      case "--engine" :: v :: rest      => parse(rest, cfg(o.config.copy(engine = v)))
+      case "--pipe" :: v :: rest        => parse(rest, cfg(o.config.copy(pipe = TANHFP32PipeConfig.fromString(v))))
+      case "--mul-trunc" :: v :: rest   => parse(rest, cfg(o.config.copy(mulTrunc = v.toInt)))
+      case "--add-width" :: v :: rest   => parse(rest, cfg(o.config.copy(addWidth = v.toInt)))
+      case "--fwd-width" :: v :: rest   => parse(rest, cfg(o.config.copy(fwdWidth = v.toInt)))
+      case "--in-format" :: v :: rest   => parse(rest, cfg(o.config.copy(inFormat = v)))
+      case "--out-format" :: v :: rest  => parse(rest, cfg(o.config.copy(outFormat = v)))
+      case "--lut" :: v :: rest         => parse(rest, cfg(o.config.copy(lutFile = v)))
+      case "--fixup" :: v :: rest       => parse(rest, cfg(o.config.copy(fixupFile = Some(v))))
+      case "--tag-width" :: v :: rest   => parse(rest, cfg(o.config.copy(tagWidth = v.toInt)))
+      case "--cdc" :: v :: rest         => parse(rest, o.copy(cdcLanes = Some(v.toInt)))
+      case "--shared" :: v :: rest      => parse(rest, o.copy(sharedPorts = Some(v.toInt)))
+      case "--weights" :: v :: rest     => parse(rest, o.copy(weights = Some(v.split(",").map(_.toInt).toSeq)))
+      case "--resp-depth" :: v :: rest  => parse(rest, o.copy(respDepth = v.toInt))
+      case "--target-dir" :: v :: rest  => parse(rest, o.copy(targetDir = v))
+      case opt :: _ =>
+        println(s"Unknown option '$opt'\n$usage")
+        sys.exit(1)
+    }
+  }
+  
+  val opts   = parse(args.toList, Options())
+  val config = opts.config
+  println(s"$config, latency ${config.pipe.latency(config.degree)} cycles")
+  
+  // Weights alone imply one port per weight
+  val sharedWeights = opts.sharedPorts.orElse(opts.weights.map(_.length)).map { ports =>
+    val w = opts.weights.getOrElse(Seq.fill(ports)(1))
+    require(w.length == ports, s"${w.length} weights for $ports ports")
+    w
+  }
+  
   ChiselStage.emitSystemVerilogFile(
-    new TANHFP32,
-    Array("--target-dir", "rtl"),
+    (opts.cdcLanes, sharedWeights) match {
+      case (Some(lanes), _) => new TANHFP32CDC(config, lanes)
+      case (_, Some(w))     => new TANHFP32Shared(config, w, opts.respDepth)
+      case _                => new TANHFP32(config)
+    },
+    Array("--target-dir", opts.targetDir),
     Array("-lowering-options=disallowLocalVariables")
   )
 }